@@ -20,13 +20,12 @@
 
 SNESpad * snes = new SNESpad(CLOCK_PIN, LATCH_PIN, DATA0_PIN, DATA1_PIN, IOSEL_PIN);
 
-bool key_release = false;
-bool key_special = false;
-bool key_caps_locked = false;
-bool key_caps_pressed = false;
+snespad_keyboard_t keyboard; // scancode decoder (held keys, caps lock led)
 
 void setup() {
   // initialize snes controller reading
+  snespad_keyboard_init(&keyboard);
+  snes->setKeyboard(&keyboard); // decode keyboard scancodes every poll
   snes->begin(); // init snes gpio
   snes->start(); // init snes read
 
@@ -68,53 +67,15 @@ void loop() {
     else Keyboard.release(KEY_RETURN);
   }
 
-  // is SNES Xband keyboard, then map hid output
-  if (snes->type == SNES_PAD_KEYBOARD) {
-    uint8_t num = snes->scancodes_len;
-    uint8_t n;
+  // key changes decoded during the last poll (releases on unplug too)
+  for (uint8_t n = 0; n < keyboard.changes_len; n++) {
+    uint16_t change = keyboard.changes[n];
+    uint8_t keycode = SNESpad::getHidKeycode(change & 0xFF, change & SNESPAD_KEY_SPECIAL);
 
-    if (num) { // has scancodes
-      for (n = 0; n < num; n++) {
-        uint8_t scancode = snes->scancodes[n];
-        // normal key key_release scancode
-        if (scancode == SNES_KEY_RELEASE) {
-          key_release = true;
-        }
-    
-        // special key key_release scancode
-        else if (scancode == SNES_KEY_SPECIAL) {
-          key_special = true;
-        }
-    
-        // normal key scancodes
-        else {
-          // Print the character corresponding to the scancode.
-          XbandKeyMapping key = snes->getKeyFromScancode(scancode, key_special);
-
-          // Toggle capsLock on press and only again once released and pressed
-          if (scancode == SNES_KEY_CAPS) {
-            if (key_release) {
-              key_caps_pressed = false;
-            } else if (!key_caps_pressed) {
-              key_caps_pressed = true;
-              key_caps_locked = !key_caps_locked;
-              snes->setCapsLockLed(key_caps_locked);
-            }
-          }
-
-          // handle keyboard output
-          if (key_release) {
-             Keyboard.release(key.hid_keycode);
-          } else if (key.releasable) {
-             Keyboard.press(key.hid_keycode);
-          } else {
-             Keyboard.write(key.hid_keycode);
-          }
-
-          key_release = false;
-          key_special = false;
-        }
-      }
+    if (change & SNESPAD_KEY_RELEASED) {
+      Keyboard.release(keycode);
+    } else {
+      Keyboard.press(keycode);
     }
   }
 }
@@ -0,0 +1,387 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  snespad_analyze: decode logic analyzer captures of an SNES port.
+
+  snespad_analyze [-f vcd|csv] [-m line=name]... [-r hz]
+                  [-t latch,low,high,setup] [-o log] [-q] capture|-
+
+  Prints one line per transaction (time, device type, raw packet, decoded
+  input) and one per timing violation or keyboard resync, then a summary on
+  stderr. Files are memory mapped and read a window at a time, "-" streams
+  stdin; neither keeps more than a window of the capture in memory.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _DEFAULT_SOURCE
+
+#include "snespad_c.h"
+#include "snespad_capture.h"
+#include "snespad_log.h"
+#include "snespad_sniff.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#define WINDOW  (4u << 20)      // bytes parsed per mapped window or read
+
+#define LRG_HEADER  0x72
+
+typedef struct {
+    snespad_capture_t cap;
+    snespad_t pad;              // Decodes each transaction like snespad_poll()
+    snespad_bus_t bus;          // Only the clock: capture time
+    snespad_log_t log;
+    FILE* log_file;
+    bool quiet;
+    uint32_t types[5];          // Transactions per pad type + 1
+
+    // Options, applied once the format is known
+    int format;                 // -1 = detect
+    const char* names[5];
+    snespad_capture_limits_t limits;
+    bool limits_set;
+    uint64_t samplerate;
+} analyze_t;
+
+static const char* const type_names[5] = {
+    "none", "controller", "nes", "mouse", "keyboard"
+};
+
+static const char* const issue_names[SNESPAD_ISSUE_KINDS] = {
+    "short-latch", "short-clock-low", "short-clock-high", "late-sample", "keyboard-resync"
+};
+
+static const char* const line_names[5] = {
+    "latch", "clock", "data0", "data1", "iobit"
+};
+
+static uint32_t analyze_now_us(void* ctx)
+{
+    const analyze_t* a = (const analyze_t*)ctx;
+    return (uint32_t)(a->cap.now_ns / 1000);
+}
+
+static void analyze_log_write(void* ctx, const uint8_t* data, uint32_t len)
+{
+    fwrite(data, 1, len, (FILE*)ctx);
+}
+
+static void print_time(uint64_t ns)
+{
+    printf("%" PRIu64 ".%09" PRIu64, ns / 1000000000, ns % 1000000000);
+}
+
+static void on_frame(void* ctx, uint64_t latch_ns, const snespad_frame_t* frame)
+{
+    analyze_t* a = (analyze_t*)ctx;
+    snespad_t* pad = &a->pad;
+    snespad_input_t input;
+
+    snespad_sniff_decode(pad, frame);
+    a->types[pad->type + 1]++;
+    if (a->quiet) {
+        return;
+    }
+
+    print_time(latch_ns);
+    printf(" %-10s %08" PRIx32 "/%u", type_names[pad->type + 1], frame->packet, frame->bits);
+
+    switch (pad->type) {
+        case SNESPAD_CONTROLLER:
+        case SNESPAD_NES:
+            printf(" buttons=%04x", pad->buttons);
+            break;
+        case SNESPAD_MOUSE:
+            snespad_decode_packet(pad->type, ~frame->packet, &input);
+            printf(" buttons=%04x dx=%d dy=%d speed=%u", pad->buttons, input.dx, input.dy,
+                   pad->mouse_speed);
+            break;
+        case SNESPAD_KEYBOARD:
+            printf(" id=%02x count=%u scancodes=", frame->kid, frame->num);
+            for (uint8_t i = 0; i < frame->scancodes_len; i++) {
+                printf("%s%02x", i ? "," : "", frame->scancodes[i]);
+            }
+            if (!frame->scancodes_len) {
+                printf("-");
+            }
+            break;
+        default:
+            break;
+    }
+    if (frame->speed_pulses) {
+        printf(" speed-pulses=%u", frame->speed_pulses);
+    }
+    if (frame->bits >= 16 && (frame->iobit >> 8) == LRG_HEADER) {
+        printf(" rumble=%02x", frame->iobit & 0xFF);
+    }
+    if (frame->extra_clocks) {
+        printf(" extra-clocks=%u", frame->extra_clocks);
+    }
+    printf("\n");
+}
+
+static void on_issue(void* ctx, const snespad_capture_issue_t* issue)
+{
+    const analyze_t* a = (const analyze_t*)ctx;
+
+    if (a->quiet) {
+        return;
+    }
+    print_time(issue->time_ns);
+    printf(" ! %s", issue_names[issue->kind]);
+    if (issue->kind != SNESPAD_ISSUE_RESYNC) {
+        for (uint8_t i = 0; i < 5; i++) {
+            if (issue->line == 1 << i) {
+                printf(" %s", line_names[i]);
+            }
+        }
+        printf(" %" PRIu32 "ns < %" PRIu32 "ns", issue->width_ns, issue->limit_ns);
+    }
+    printf("\n");
+}
+
+static bool parse_map(analyze_t* a, const char* arg)
+{
+    const char* eq = strchr(arg, '=');
+
+    if (!eq || strlen(eq + 1) >= SNESPAD_CAPTURE_NAME_MAX) {
+        return false;
+    }
+    for (uint8_t i = 0; i < 5; i++) {
+        if (strlen(line_names[i]) == (size_t)(eq - arg) && !strncmp(arg, line_names[i], eq - arg)) {
+            a->names[i] = eq + 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_limits(snespad_capture_limits_t* limits, const char* arg)
+{
+    unsigned latch, low, high, setup;
+
+    if (sscanf(arg, "%u,%u,%u,%u", &latch, &low, &high, &setup) != 4) {
+        return false;
+    }
+    limits->latch_ns = latch;
+    limits->clock_low_ns = low;
+    limits->clock_high_ns = high;
+    limits->setup_ns = setup;
+    return true;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+            "usage: snespad_analyze [-f vcd|csv] [-m line=name]... [-r hz]\n"
+            "                       [-t latch,low,high,setup] [-o log] [-q] capture|-\n"
+            "  -f  capture format (default: from the file contents)\n"
+            "  -m  signal or column name of latch, clock, data0, data1 or iobit\n"
+            "  -r  CSV samplerate when the export has none\n"
+            "  -t  timing limits in ns (default 2000,4000,4000,3000)\n"
+            "  -o  write the transactions as a replay log (snespad_log.h)\n"
+            "  -q  summary only\n");
+}
+
+// Set up the analyzer for the capture's format
+static void analyze_setup(analyze_t* a, const char* head, size_t len)
+{
+    snespad_capture_t* cap = &a->cap;
+
+    snespad_capture_init(cap, a->format >= 0 ? (uint8_t)a->format : snespad_capture_detect(head, len));
+    for (uint8_t i = 0; i < 5; i++) {
+        if (a->names[i]) {
+            snespad_capture_map(cap, 1 << i, a->names[i]);
+        }
+    }
+    if (a->limits_set) {
+        cap->limits = a->limits;
+    }
+    if (a->samplerate) {
+        snespad_capture_set_samplerate(cap, a->samplerate);
+    }
+    snespad_capture_set_handlers(cap, on_frame, on_issue, a);
+}
+
+// Feed a mapped file a window at a time, dropping each window once parsed
+// Returns: false if the file cannot be mapped
+static bool analyze_file(analyze_t* a, int fd, uint64_t* bytes)
+{
+    struct stat st;
+    const char* data;
+    size_t size;
+
+    if (fstat(fd, &st) || !S_ISREG(st.st_mode) || !st.st_size) {
+        return false;
+    }
+    size = (size_t)st.st_size;
+
+    data = (const char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    madvise((void*)data, size, MADV_SEQUENTIAL);
+    analyze_setup(a, data, size < WINDOW ? size : WINDOW);
+
+    for (size_t off = 0; off < size; off += WINDOW) {
+        size_t n = size - off < WINDOW ? size - off : WINDOW;
+
+        snespad_capture_feed(&a->cap, data + off, n);
+        madvise((void*)(data + off), n, MADV_DONTNEED);
+    }
+    munmap((void*)data, size);
+    *bytes = size;
+    return true;
+}
+
+// Feed a pipe (or anything else that cannot be mapped) as it is read
+// Returns: false on a read error
+static bool analyze_stream(analyze_t* a, int fd, uint64_t* bytes)
+{
+    static char buf[WINDOW];
+    bool first = true;
+    ssize_t n;
+
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        if (first) {
+            analyze_setup(a, buf, (size_t)n);
+            first = false;
+        }
+        snespad_capture_feed(&a->cap, buf, (size_t)n);
+        *bytes += (uint64_t)n;
+    }
+    if (first) {
+        analyze_setup(a, "", 0);
+    }
+    return n == 0;
+}
+
+static void print_summary(const analyze_t* a, uint64_t bytes, double secs)
+{
+    const snespad_capture_t* cap = &a->cap;
+
+    fprintf(stderr, "%" PRIu64 " bytes in %.3f s (%.1f MB/s), %.6f s of bus time\n",
+            bytes, secs, secs > 0 ? bytes / secs / 1e6 : 0.0, cap->now_ns / 1e9);
+    fprintf(stderr, "%" PRIu64 " edges, %" PRIu32 " transactions:", cap->edges, cap->frames);
+    for (uint8_t i = 0; i < 5; i++) {
+        fprintf(stderr, " %s %" PRIu32, type_names[i], a->types[i]);
+    }
+    fprintf(stderr, "\nissues:");
+    for (uint8_t i = 0; i < SNESPAD_ISSUE_KINDS; i++) {
+        fprintf(stderr, " %s %" PRIu32, issue_names[i], cap->issues[i]);
+    }
+    fprintf(stderr, "\nparse errors: %" PRIu32 "\n", cap->errors);
+}
+
+int main(int argc, char** argv)
+{
+    static analyze_t a;
+    const char* path = NULL;
+    const char* log_path = NULL;
+    uint64_t bytes = 0;
+    struct timespec t0, t1;
+    int fd;
+    bool ok;
+
+    a.format = -1;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+
+        if (!strcmp(arg, "-q")) {
+            a.quiet = true;
+        } else if (i + 1 < argc && !strcmp(arg, "-f")) {
+            arg = argv[++i];
+            if (!strcmp(arg, "vcd")) {
+                a.format = SNESPAD_CAPTURE_VCD;
+            } else if (!strcmp(arg, "csv")) {
+                a.format = SNESPAD_CAPTURE_CSV;
+            } else {
+                usage();
+                return 2;
+            }
+        } else if (i + 1 < argc && !strcmp(arg, "-m")) {
+            if (!parse_map(&a, argv[++i])) {
+                fprintf(stderr, "bad mapping: %s\n", argv[i]);
+                return 2;
+            }
+        } else if (i + 1 < argc && !strcmp(arg, "-r")) {
+            a.samplerate = strtoull(argv[++i], NULL, 10);
+        } else if (i + 1 < argc && !strcmp(arg, "-t")) {
+            if (!parse_limits(&a.limits, argv[++i])) {
+                fprintf(stderr, "bad limits: %s\n", argv[i]);
+                return 2;
+            }
+            a.limits_set = true;
+        } else if (i + 1 < argc && !strcmp(arg, "-o")) {
+            log_path = argv[++i];
+        } else if (!path && (arg[0] != '-' || !arg[1])) {
+            path = arg;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (!path) {
+        usage();
+        return 2;
+    }
+
+    fd = strcmp(path, "-") ? open(path, O_RDONLY) : STDIN_FILENO;
+    if (fd < 0) {
+        perror(path);
+        return 1;
+    }
+
+    // Transactions are decoded by a pad whose clock is the capture time
+    a.bus.now_us = analyze_now_us;
+    a.bus.ctx = &a;
+    snespad_init(&a.pad, 1, 0, 2, 3, 4);
+    snespad_set_bus(&a.pad, &a.bus);
+    if (log_path) {
+        a.log_file = fopen(log_path, "wb");
+        if (!a.log_file) {
+            perror(log_path);
+            return 1;
+        }
+        snespad_log_init_stream(&a.log, analyze_log_write, a.log_file);
+        snespad_set_record(&a.pad, &a.log);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    ok = analyze_file(&a, fd, &bytes) || analyze_stream(&a, fd, &bytes);
+    snespad_capture_end(&a.cap);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    if (a.log_file) {
+        snespad_log_flush(&a.log);
+        fclose(a.log_file);
+    }
+    fflush(stdout);
+    print_summary(&a, bytes, (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9);
+    if (!ok) {
+        perror(path);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Host micro-benchmark for packet decoding: the former per-type switch with
+  a bit-by-bit byte reversal for the mouse axes against the table-driven
+  snespad_decode_packet(). Both are first checked against each other for
+  every 16-bit controller and NES packet and every mouse axis pattern.
+  See README.md in this directory for the build line.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "snespad_c.h"
+
+#define PACKETS     (1 << 16)  // packet stream length
+#define RUNS        20
+
+typedef struct {
+    uint16_t buttons;
+    uint16_t mouse_x;
+    uint16_t mouse_y;
+} decoded_t;
+
+static uint32_t stream[PACKETS];
+static int8_t stream_type[PACKETS];
+static volatile uint32_t sink;
+
+static uint32_t rng = 0x12345678;
+
+static uint32_t next_random(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint8_t legacy_reverse_byte(uint8_t c)
+{
+    uint8_t r = 0;
+    for (int i = 0; i < 8; i++) {
+        r <<= 1;
+        r |= c & 1;
+        c >>= 1;
+    }
+    return r;
+}
+
+// The decode as it was done before the lookup tables
+static void legacy_decode(int8_t type, int32_t state, decoded_t* out)
+{
+    memset(out, 0, sizeof(*out));
+
+    switch (type) {
+        case SNESPAD_CONTROLLER:
+            out->buttons = state & SNES_BUTTONS;
+            break;
+
+        case SNESPAD_NES:
+            out->buttons = (state & (SNES_SELECT | SNES_START | SNES_UP | SNES_DOWN | SNES_LEFT | SNES_RIGHT)) |
+                           ((state & SNES_B) ? SNES_A : 0) |
+                           ((state & SNES_Y) ? SNES_B : 0);
+            break;
+
+        case SNESPAD_MOUSE: {
+            int x, y;
+
+            x = (state & SNES_MOUSE_X) >> 25;
+            x = legacy_reverse_byte(x) * SNES_MOUSE_PRECISION;
+            x = (state & SNES_MOUSE_X_SIGN) ? 127 - x : 127 + x;
+
+            y = (state & SNES_MOUSE_Y) >> 17;
+            y = legacy_reverse_byte(y) * SNES_MOUSE_PRECISION;
+            y = (state & SNES_MOUSE_Y_SIGN) ? 127 - y : 127 + y;
+
+            out->mouse_x = x;
+            out->mouse_y = y;
+            out->buttons = (state & SNES_A) | ((state & SNES_X) ? SNES_B : 0);
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+// The table decode plus the mouse position snespad_poll() derives from it
+static void table_decode(int8_t type, uint32_t state, decoded_t* out)
+{
+    snespad_input_t input;
+
+    snespad_decode_packet(type, state, &input);
+    out->buttons = input.buttons;
+    out->mouse_x = type == SNESPAD_MOUSE ? 127 + input.dx * 2 * SNES_MOUSE_PRECISION : 0;
+    out->mouse_y = type == SNESPAD_MOUSE ? 127 + input.dy * 2 * SNES_MOUSE_PRECISION : 0;
+}
+
+static int check(int8_t type, uint32_t state)
+{
+    decoded_t a, b;
+
+    legacy_decode(type, state, &a);
+    table_decode(type, state, &b);
+    if (a.buttons != b.buttons || a.mouse_x != b.mouse_x || a.mouse_y != b.mouse_y) {
+        printf("type %d packet %08X: legacy %03X %u,%u table %03X %u,%u\n", type, state,
+               a.buttons, a.mouse_x, a.mouse_y, b.buttons, b.mouse_x, b.mouse_y);
+        return 1;
+    }
+    return 0;
+}
+
+// Every low half for each type (upper half random), and for the mouse every
+// upper half (both axes) with random buttons
+static int verify(void)
+{
+    static const int8_t types[] = {SNESPAD_NONE, SNESPAD_CONTROLLER, SNESPAD_NES, SNESPAD_MOUSE, SNESPAD_KEYBOARD};
+    int mismatches = 0;
+    uint32_t checked = 0;
+
+    for (unsigned t = 0; t < sizeof(types); t++) {
+        for (uint32_t low = 0; low < 0x10000; low++) {
+            mismatches += check(types[t], (next_random() & 0xFFFF0000) | low);
+            checked++;
+        }
+    }
+    for (uint32_t high = 0; high < 0x10000; high++) {
+        mismatches += check(SNESPAD_MOUSE, high << 16 | (next_random() & 0xFFFF));
+        checked++;
+    }
+
+    printf("verify: %u packets, %d mismatches\n", checked, mismatches);
+    return mismatches;
+}
+
+static double time_legacy(void)
+{
+    double best = 0;
+
+    for (int run = 0; run < RUNS; run++) {
+        uint32_t acc = 0;
+        double t0 = now_ns();
+        for (int i = 0; i < PACKETS; i++) {
+            decoded_t d;
+            legacy_decode(stream_type[i], stream[i], &d);
+            acc += d.buttons + d.mouse_x + d.mouse_y;
+        }
+        double t = (now_ns() - t0) / PACKETS;
+        sink = acc;
+        if (run == 0 || t < best) best = t;
+    }
+
+    return best;
+}
+
+static double time_table(void)
+{
+    double best = 0;
+
+    for (int run = 0; run < RUNS; run++) {
+        uint32_t acc = 0;
+        double t0 = now_ns();
+        for (int i = 0; i < PACKETS; i++) {
+            decoded_t d;
+            table_decode(stream_type[i], stream[i], &d);
+            acc += d.buttons + d.mouse_x + d.mouse_y;
+        }
+        double t = (now_ns() - t0) / PACKETS;
+        sink = acc;
+        if (run == 0 || t < best) best = t;
+    }
+
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    bool verify_only = argc > 1 && !strcmp(argv[1], "--verify");
+    int mismatches = verify();
+
+    if (mismatches || verify_only) {
+        return mismatches != 0;
+    }
+
+    // Mixed stream: controllers, NES pads and mice in random order
+    for (int i = 0; i < PACKETS; i++) {
+        uint32_t r = next_random();
+        stream_type[i] = r % 3;
+        stream[i] = next_random();
+    }
+
+    printf("decode (ns/packet)  legacy  table\n");
+    printf("mixed types        %7.2f %6.2f\n", time_legacy(), time_table());
+    printf("table size (bytes) %d buttons + %d reverse, flash\n", 4 * 3 * 16 * 2, 256);
+    return 0;
+}
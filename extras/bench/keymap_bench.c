@@ -0,0 +1,376 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Host micro-benchmark for keyboard scancode lookups: the former nibble
+  swapped [16][10] mapping table with a switch for special keys against
+  the flat keycode table and releasable bitmap, plus the memory each
+  layout needs. See README.md in this directory for the build line.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "snespad_c.h"
+
+#define LOOKUPS     (1 << 16)  // scancode stream length
+#define RUNS        20
+
+// ============================================================================
+// Former Xband Keyboard Mapping Table (verbatim from snespad.c before the
+// flat table, so the agreement check has an independent baseline)
+// ============================================================================
+// Maps scancodes to key names and HID keycodes
+// Indexed by [scancode & 0x0F][(scancode & 0xF0) >> 4]
+
+static const snespad_key_mapping_t legacy_table[16][10] = {
+    // 0xh, 1xh, 2xh, 3xh, 4xh, 5xh, 6xh, 7xh, 8xh, 9xh
+    {
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"NUM-0", '0', 0},
+        {"OpenX", KEY_LEFT_GUI, 1},
+        {"90h", 0, 0}
+    }, // x0h
+    {
+        {"F1", KEY_F1, 0},
+        {"Alt", KEY_LEFT_ALT, 1},
+        {"C", 'c', 0},
+        {"N", 'n', 0},
+        {",<", ',', 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"NUM-.", '.', 0},
+        {"ClosedX", KEY_RIGHT_GUI, 1},
+        {"91h", 0, 0}
+    }, // x1h
+    {
+        {"F2", KEY_F2, 0},
+        {"LShft", KEY_LEFT_SHIFT, 1},
+        {"X", 'x', 0},
+        {"B", 'b', 0},
+        {"K", 'k', 0},
+        {"\"'", '\'', 0},
+        {"unused", 0, 0},
+        {"NUM-2", '2', 0},
+        {"unused", 0, 0},
+        {"92h", 0, 0}
+    }, // x2h
+    {
+        {"F3", KEY_F3, 0},
+        {"unused", 0, 0},
+        {"D", 'd', 0},
+        {"H", 'h', 0},
+        {"I", 'i', 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"NUM-5", '5', 0},
+        {"unused", 0, 0},
+        {"93h", 0, 0}
+    }, // x3h
+    {
+        {"F4", KEY_F4, 0},
+        {"LCtl", KEY_LEFT_CTRL, 1},
+        {"E", 'e', 0},
+        {"G", 'g', 0},
+        {"O", 'o', 0},
+        {"[{", '[', 0},
+        {"unused", 0, 0},
+        {"NUM-6", '6', 0},
+        {"NUM-SUB", 0, 0},
+        {"94h", 0, 0}
+    }, // x4h
+    {
+        {"F5", KEY_F5, 0},
+        {"Q", 'q', 0},
+        {"4$", '4', 0},
+        {"Y", 'y', 0},
+        {"0)", '0', 0},
+        {"=+", '=', 0},
+        {"unused", 0, 0},
+        {"NUM-8", '8', 0},
+        {"unused", 0, 0},
+        {"95h", 0, 0}
+    }, // x5h
+    {
+        {"F6", KEY_F6, 0},
+        {"1!", '1', 0},
+        {"3#", '3', 0},
+        {"6^", '6', 0},
+        {"9(", '9', 0},
+        {"unused", 0, 0},
+        {"BACKSPACE", KEY_BACKSPACE, 0},
+        {"ESC", KEY_ESC, 0},
+        {"JOY-A", 0, 0},
+        {"96h", 0, 0}
+    }, // x6h
+    {
+        {"F7", KEY_F7, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"NUM-DIV", 0, 0},
+        {"JOY-B", 0, 0},
+        {"97h", 0, 0}
+    }, // x7h
+    {
+        {"F8", KEY_F8, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"CAPS", KEY_CAPS_LOCK, 1},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"JOY-X", 0, 0},
+        {"98h", 0, 0}
+    }, // x8h
+    {
+        {"F9", KEY_F9, 0},
+        {"unused", 0, 0},
+        {"SPACE", ' ', 0},
+        {"unused", 0, 0},
+        {".>", '.', 0},
+        {"RShft", KEY_RIGHT_SHIFT, 1},
+        {"NUM-1", '1', 0},
+        {"NUM-RET", 0, 0},
+        {"JOY-Y", 0, 0},
+        {"99h", 0, 0}
+    }, // x9h
+    {
+        {"F10", KEY_F10, 0},
+        {"Z", 'z', 0},
+        {"V", 'v', 0},
+        {"M", 'm', 0},
+        {"/?", '/', 0},
+        {"ENTER", KEY_RETURN, 0},
+        {"unused", 0, 0},
+        {"NUM-3", '3', 0},
+        {"JOY-L", 0, 0},
+        {"9Ah", 0, 0}
+    }, // xAh
+    {
+        {"F11", KEY_F11, 0},
+        {"S", 's', 0},
+        {"F", 'f', 0},
+        {"J", 'j', 0},
+        {"L", 'l', 0},
+        {"]}", ']', 0},
+        {"NUM-4", '4', 0},
+        {"unused", 0, 0},
+        {"JOY-R", 0, 0},
+        {"9Bh", 0, 0}
+    }, // xBh
+    {
+        {"F12", KEY_F12, 0},
+        {"A", 'a', 0},
+        {"T", 't', 0},
+        {"U", 'u', 0},
+        {";:", ';', 0},
+        {"unused", 0, 0},
+        {"NUM-7", '7', 0},
+        {"NUM-ADD", '+', 0},
+        {"SELECT", 0, 0},
+        {"9Ch", 0, 0}
+    }, // xCh
+    {
+        {"Switch", KEY_TAB, 0},
+        {"W", 'w', 0},
+        {"R", 'r', 0},
+        {"7&", '7', 0},
+        {"P", 'p', 0},
+        {"\\", '\\', 0},
+        {"unused", 0, 0},
+        {"NUM-9", '9', 0},
+        {"START", 0, 0},
+        {"9Dh", 0, 0}
+    }, // xDh
+    {
+        {"`~", '`', 0},
+        {"2@", '2', 0},
+        {"5%", '5', 0},
+        {"8*", '8', 0},
+        {"-_", '-', 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"NUM-MUL", '*', 0},
+        {"8Eh", 0, 0},
+        {"unused", 0, 0}
+    }, // xEh
+    {
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"unused", 0, 0},
+        {"8Fh", 0, 0},
+        {"unused", 0, 0}
+    }  // xFh
+};
+
+static uint8_t stream[LOOKUPS];
+static bool stream_special[LOOKUPS];
+static volatile uint32_t sink;
+
+static uint32_t rng = 0x12345678;
+
+static uint32_t next_random(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// The lookup as it was done before the flat table
+static snespad_key_mapping_t legacy_lookup(uint8_t scancode, bool special)
+{
+    snespad_key_mapping_t key = {"unused", 0, 0};
+
+    if (special) {
+        // Special scancodes (preceded by SNES_KEY_SPECIAL scancode)
+        switch (scancode) {
+            case SNES_KEY_RETURN:
+                key.key_string = "JOY-A";
+                key.hid_keycode = KEY_RETURN;
+                key.releasable = true;
+                break;
+            case SNES_KEY_LEFT:
+                key.key_string = "LEFT";
+                key.hid_keycode = KEY_LEFT_ARROW;
+                key.releasable = true;
+                break;
+            case SNES_KEY_DOWN:
+                key.key_string = "DOWN";
+                key.hid_keycode = KEY_DOWN_ARROW;
+                key.releasable = true;
+                break;
+            case SNES_KEY_RIGHT:
+                key.key_string = "RIGHT";
+                key.hid_keycode = KEY_RIGHT_ARROW;
+                key.releasable = true;
+                break;
+            case SNES_KEY_UP:
+                key.key_string = "UP";
+                key.hid_keycode = KEY_UP_ARROW;
+                key.releasable = true;
+                break;
+        }
+    } else {
+        // Normal scancodes
+        key = legacy_table[(scancode & 0x0F)][((scancode & 0xF0) >> 4)];
+    }
+
+    return key;
+}
+
+static double time_legacy(void)
+{
+    double best = 0;
+
+    for (int run = 0; run < RUNS; run++) {
+        uint32_t acc = 0;
+        double t0 = now_ns();
+        for (int i = 0; i < LOOKUPS; i++) {
+            snespad_key_mapping_t key = legacy_lookup(stream[i], stream_special[i]);
+            acc += key.hid_keycode + key.releasable;
+        }
+        double t = (now_ns() - t0) / LOOKUPS;
+        sink = acc;
+        if (run == 0 || t < best) best = t;
+    }
+
+    return best;
+}
+
+static double time_flat(void)
+{
+    double best = 0;
+
+    for (int run = 0; run < RUNS; run++) {
+        uint32_t acc = 0;
+        double t0 = now_ns();
+        for (int i = 0; i < LOOKUPS; i++) {
+            acc += snespad_key_hid(stream[i], stream_special[i]) +
+                   snespad_key_releasable(stream[i], stream_special[i]);
+        }
+        double t = (now_ns() - t0) / LOOKUPS;
+        sink = acc;
+        if (run == 0 || t < best) best = t;
+    }
+
+    return best;
+}
+
+int main(void)
+{
+    static const uint8_t arrows[4] = {SNES_KEY_LEFT, SNES_KEY_DOWN, SNES_KEY_RIGHT, SNES_KEY_UP};
+    int mismatches = 0;
+
+    // Typing mix: mostly plain keys, some arrows
+    for (int i = 0; i < LOOKUPS; i++) {
+        uint32_t r = next_random();
+        stream_special[i] = (r & 7) == 0;
+        stream[i] = stream_special[i] ? arrows[(r >> 3) & 3] : (r >> 8) % 0xA0;
+    }
+
+    for (int special = 0; special < 2; special++) {
+        for (int code = 0; code < 0xA0; code++) {
+            snespad_key_mapping_t key = legacy_lookup(code, special);
+            if (key.hid_keycode != snespad_key_hid(code, special) ||
+                key.releasable != snespad_key_releasable(code, special)) {
+                mismatches++;
+            }
+        }
+    }
+    if (mismatches) {
+        printf("%d scancodes differ from the legacy table\n", mismatches);
+        return 1;
+    }
+
+    printf("lookup (ns)       legacy   flat\n");
+    printf("keycode+release  %7.2f %6.2f\n\n", time_legacy(), time_flat());
+
+    // AVR sizes: 2-byte pointers, so each legacy entry is 4 bytes
+    printf("memory (bytes)              host    avr\n");
+    printf("legacy table, per instance %5zu  %5d  RAM (C++ member)\n",
+           sizeof(legacy_table), 16 * 10 * 4);
+    printf("flat keycodes + bitmap     %5d  %5d  flash, shared\n", 512 + 64, 512 + 64);
+    printf("key names (optional)       %5zu  %5d  only if names are used\n",
+           256 * sizeof(const char*), 256 * 2);
+    return 0;
+}
@@ -0,0 +1,328 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Host benchmark for the poll pipeline on the simulated bus. Every case
+  reports CPU time per operation together with the virtual bus time and
+  line activity the simulation recorded for it, as JSON (default) or CSV,
+  so results can be kept and compared between releases. See README.md in
+  this directory for the build line.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "snespad_c.h"
+#include "snespad_device.h"
+#include "snespad_group.h"
+#include "snespad_sim.h"
+#include "snespad_sniff.h"
+
+#define RUNS            5
+#define MAX_PORTS       4
+
+typedef struct {
+    const char* name;
+    uint8_t kind;               // SNESPAD_SIM_* plugged into every port
+    uint8_t ports;              // > 1 polls the ports as a group
+    void (*op)(uint32_t i);
+} bench_case_t;
+
+typedef struct {
+    double cpu_ns;              // Best run, per operation
+    double bus_us;              // Virtual bus time per operation
+    double latches;
+    double clocks;
+    double pin_ops;             // Pin writes and reads
+} bench_result_t;
+
+static snespad_sim_t sim;
+static snespad_t pads[MAX_PORTS];
+static snespad_group_t group;
+static volatile uint32_t sink;
+
+// Device mode answering the simulated console
+#define DEVICE_DATA_PIN 20
+static snespad_device_t device;
+
+// Sniffer decoding the polls of pads[0] into a second pad
+static snespad_t spy;
+static snespad_sniffer_t sniffer;
+
+// Recorded mouse session for the replay case
+#define REPLAY_POLLS    4096
+static uint8_t replay_buf[16384];
+static snespad_log_t replay_log;
+
+// Scancodes typed during the keyboard case: 'a', Shift press/release
+static const uint8_t typing[] = {0x1C, 0x12, 0x1C, SNES_KEY_RELEASE, 0x12};
+
+static double cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void op_poll(uint32_t i)
+{
+    (void)i;
+    snespad_poll(&pads[0]);
+}
+
+static void op_poll_mouse(uint32_t i)
+{
+    snespad_sim_mouse_move(&sim, 0, (int)(i % 7) - 3, (int)(i % 5) - 2);
+    snespad_poll(&pads[0]);
+}
+
+static void op_poll_typing(uint32_t i)
+{
+    snespad_sim_key(&sim, 0, typing[i % sizeof(typing)]);
+    snespad_poll(&pads[0]);
+}
+
+static void op_replay(uint32_t i)
+{
+    (void)i;
+    if (replay_log.pos >= replay_log.data_len && !replay_log.run) {
+        snespad_log_open(&replay_log, replay_buf, replay_log.data_len);
+    }
+    snespad_poll(&pads[0]);
+}
+
+static void op_device(uint32_t i)
+{
+    snespad_device_set_buttons(&device, i & SNES_BUTTONS);
+    sink += snespad_sim_console_read(&sim, DEVICE_DATA_PIN, 16, 0);
+}
+
+static void op_sniff(uint32_t i)
+{
+    snespad_sim_set_buttons(&sim, 0, i & SNES_BUTTONS);
+    snespad_poll(&pads[0]);
+    snespad_sniffer_task(&sniffer);
+    sink += spy.buttons;
+}
+
+static void op_start(uint32_t i)
+{
+    (void)i;
+    snespad_start(&pads[0]);
+}
+
+static void op_group_poll(uint32_t i)
+{
+    (void)i;
+    snespad_group_poll(&group);
+}
+
+static void op_decode(uint32_t i)
+{
+    snespad_input_t input;
+
+    snespad_decode_packet(i % 3, i * 0x9E3779B9u, &input);
+    sink += input.buttons + input.dx + input.dy;
+}
+
+static void op_key_lookup(uint32_t i)
+{
+    snespad_key_mapping_t key = snespad_get_key_from_scancode(i & 0xFF, (i & 0x100) != 0);
+
+    sink += key.hid_keycode + key.releasable;
+}
+
+static const bench_case_t cases[] = {
+    {"poll_controller",     SNESPAD_SIM_PAD,      1, op_poll},
+    {"poll_nes",            SNESPAD_SIM_NES,      1, op_poll},
+    {"poll_mouse",          SNESPAD_SIM_MOUSE,    1, op_poll_mouse},
+    {"poll_hyperkin",       SNESPAD_SIM_HYPERKIN, 1, op_poll_mouse},
+    {"poll_keyboard_idle",  SNESPAD_SIM_KEYBOARD, 1, op_poll},
+    {"poll_keyboard_typing", SNESPAD_SIM_KEYBOARD, 1, op_poll_typing},
+    {"poll_disconnected",   SNESPAD_SIM_NONE,     1, op_poll},
+    {"start_controller",    SNESPAD_SIM_PAD,      1, op_start},
+    {"start_mouse",         SNESPAD_SIM_MOUSE,    1, op_start},
+    {"start_keyboard",      SNESPAD_SIM_KEYBOARD, 1, op_start},
+    {"group_poll_4",        SNESPAD_SIM_PAD,      4, op_group_poll},
+    {"decode_packet",       SNESPAD_SIM_NONE,     1, op_decode},
+    {"key_from_scancode",   SNESPAD_SIM_NONE,     1, op_key_lookup},
+    {"replay_mouse",        SNESPAD_SIM_MOUSE,    1, op_replay},
+    {"device_pad_read",     SNESPAD_SIM_NONE,     1, op_device},
+    {"sniff_controller",    SNESPAD_SIM_PAD,      1, op_sniff},
+};
+
+// Fresh bus with the case's device in every port, detected and settled
+static void setup(const bench_case_t* c)
+{
+    snespad_sim_init(&sim, 0, 1, 2, 3, 4);
+    snespad_group_init(&group);
+
+    for (uint8_t p = 0; p < c->ports; p++) {
+        if (p > 0) {
+            snespad_sim_add_port(&sim, 2 + 3 * p, 3 + 3 * p, 4 + 3 * p);
+        }
+        if (c->kind == SNESPAD_SIM_NONE) {
+            snespad_sim_detach(&sim, p);
+        } else {
+            snespad_sim_attach(&sim, p, c->kind);
+        }
+        snespad_init(&pads[p], 0, 1, 2 + 3 * p, 3 + 3 * p, 4 + 3 * p);
+        snespad_set_bus(&pads[p], snespad_sim_bus(&sim));
+    }
+
+    if (c->ports > 1) {
+        for (uint8_t p = 0; p < c->ports; p++) {
+            snespad_group_add(&group, &pads[p]);
+        }
+        snespad_group_begin(&group);
+        snespad_group_start(&group);
+    } else {
+        snespad_begin(&pads[0]);
+        snespad_start(&pads[0]);
+    }
+
+    // The library as the controller, read by the console side
+    if (c->op == op_device) {
+        snespad_device_init(&device, SNESPAD_CONTROLLER, 0, 1, DEVICE_DATA_PIN);
+        snespad_device_set_bus(&device, snespad_sim_bus(&sim));
+        snespad_device_begin(&device);
+    }
+
+    // Every line of port 0 watched by the sniffer as well
+    if (c->op == op_sniff) {
+        snespad_init(&spy, 0, 1, 2, 3, 4);
+        snespad_set_bus(&spy, snespad_sim_bus(&sim));
+        snespad_sniffer_init(&sniffer, &spy);
+        snespad_sniffer_begin(&sniffer);
+    }
+
+    // Record a session, then poll from the log instead of the bus
+    if (c->op == op_replay) {
+        snespad_log_t rec;
+
+        snespad_log_init(&rec, replay_buf, sizeof(replay_buf));
+        snespad_set_record(&pads[0], &rec);
+        for (uint32_t i = 0; i < REPLAY_POLLS; i++) {
+            snespad_sim_set_buttons(&sim, 0, (i & 64) ? SNES_A : 0);
+            op_poll_mouse(i);
+        }
+        snespad_log_flush(&rec);
+        snespad_set_record(&pads[0], NULL);
+
+        snespad_log_open(&replay_log, replay_buf, rec.len);
+        snespad_set_replay(&pads[0], &replay_log);
+    }
+}
+
+static void run_case(const bench_case_t* c, uint32_t iterations, bench_result_t* r)
+{
+    setup(c);
+
+    // Warm up: caches, and mouse speed / keyboard state settled
+    for (uint32_t i = 0; i < 64; i++) {
+        c->op(i);
+    }
+
+    for (int run = 0; run < RUNS; run++) {
+        snespad_sim_reset_stats(&sim);
+
+        double t0 = cpu_ns();
+        for (uint32_t i = 0; i < iterations; i++) {
+            c->op(i);
+        }
+        double t = (cpu_ns() - t0) / iterations;
+
+        if (run == 0 || t < r->cpu_ns) r->cpu_ns = t;
+    }
+
+    // Bus activity of the last run (the simulation is deterministic)
+    r->bus_us = (double)sim.stats.bus_us / iterations;
+    r->latches = (double)sim.stats.latches / iterations;
+    r->clocks = (double)sim.stats.clocks / iterations;
+    r->pin_ops = (double)(sim.stats.writes + sim.stats.reads + sim.stats.mask_reads) / iterations;
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr, "usage: %s [--csv] [--iterations N] [case...]\n", prog);
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t count = sizeof(cases) / sizeof(cases[0]);
+    uint32_t iterations = 20000;
+    bool csv = false;
+    bool selected[sizeof(cases) / sizeof(cases[0])] = {false};
+    bool any_selected = false;
+    bool first = true;
+
+    for (int a = 1; a < argc; a++) {
+        if (!strcmp(argv[a], "--csv")) {
+            csv = true;
+        } else if (!strcmp(argv[a], "--iterations") && a + 1 < argc) {
+            iterations = strtoul(argv[++a], NULL, 0);
+        } else {
+            uint32_t k;
+            for (k = 0; k < count && strcmp(argv[a], cases[k].name); k++) {
+            }
+            if (k == count) {
+                usage(argv[0]);
+                return 2;
+            }
+            selected[k] = any_selected = true;
+        }
+    }
+    if (iterations == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    if (csv) {
+        printf("case,iterations,cpu_ns,bus_us,latches,clocks,pin_ops\n");
+    } else {
+        printf("{\n  \"iterations\": %u,\n  \"cases\": [\n", iterations);
+    }
+
+    for (uint32_t k = 0; k < count; k++) {
+        bench_result_t r = {0};
+
+        if (any_selected && !selected[k]) {
+            continue;
+        }
+        run_case(&cases[k], iterations, &r);
+
+        if (csv) {
+            printf("%s,%u,%.2f,%.2f,%.3f,%.3f,%.2f\n", cases[k].name, iterations,
+                   r.cpu_ns, r.bus_us, r.latches, r.clocks, r.pin_ops);
+        } else {
+            printf("%s    {\"case\": \"%s\", \"cpu_ns\": %.2f, \"bus_us\": %.2f, "
+                   "\"latches\": %.3f, \"clocks\": %.3f, \"pin_ops\": %.2f}",
+                   first ? "" : ",\n", cases[k].name,
+                   r.cpu_ns, r.bus_us, r.latches, r.clocks, r.pin_ops);
+        }
+        first = false;
+    }
+
+    if (!csv) {
+        printf("\n  ]\n}\n");
+    }
+    return 0;
+}
@@ -0,0 +1,188 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Host round-trip check for the bus trace. A pad polls each simulated
+  device with a trace ring and a record log; the trace is written out as
+  a value change dump, parsed back with snespad_capture.h and decoded by
+  a second pad recording its own log. The check passes when both logs
+  are byte-identical and the capture reports no timing issues.
+
+  Usage: trace_check [polls]   (build with -DSNESPAD_TRACE=1)
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "snespad_c.h"
+#include "snespad_sim.h"
+#include "snespad_capture.h"
+#include "snespad_sniff.h"
+
+#if !SNESPAD_TRACE
+#error "build trace_check with -DSNESPAD_TRACE=1"
+#endif
+
+#define LOG_SIZE    (256 * 1024)
+
+// Growable byte buffer for the VCD text
+typedef struct {
+    uint8_t* data;
+    size_t len;
+    size_t size;
+} buffer_t;
+
+static void buffer_write(void* ctx, const uint8_t* data, uint32_t len)
+{
+    buffer_t* b = (buffer_t*)ctx;
+
+    if (b->len + len > b->size) {
+        b->size = (b->len + len) * 2;
+        b->data = realloc(b->data, b->size);
+        if (!b->data) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+}
+
+// Decoding side: a pad whose clock is the capture time
+typedef struct {
+    snespad_capture_t cap;
+    snespad_t pad;
+    snespad_bus_t bus;
+    uint32_t issues;
+} decoder_t;
+
+static uint32_t decoder_now_us(void* ctx)
+{
+    return (uint32_t)(((decoder_t*)ctx)->cap.now_ns / 1000);
+}
+
+static void on_frame(void* ctx, uint64_t latch_ns, const snespad_frame_t* frame)
+{
+    (void)latch_ns;
+    snespad_sniff_decode(&((decoder_t*)ctx)->pad, frame);
+}
+
+static void on_issue(void* ctx, const snespad_capture_issue_t* issue)
+{
+    decoder_t* d = (decoder_t*)ctx;
+
+    d->issues++;
+    printf("  issue %u on line %u at %llu ns: %u < %u ns\n", issue->kind, issue->line,
+           (unsigned long long)issue->time_ns, issue->width_ns, issue->limit_ns);
+}
+
+// Poll one device kind through a trace and back; returns true if it round-trips
+static bool check_kind(uint8_t kind, const char* name, int polls)
+{
+    static const uint8_t typing[] = {
+        0x1C, 0x12, 0x1C, SNES_KEY_RELEASE, 0x12, 0xE0, 0x75, 0xE0, 0xF0, 0x75
+    };
+    static uint8_t host_buf[LOG_SIZE], decoded_buf[LOG_SIZE];
+    static snespad_sim_t sim;
+    static snespad_t host;
+    static snespad_trace_t trace;
+    static decoder_t d;
+    snespad_trace_entry_t batch[64];
+    snespad_trace_vcd_t vcd;
+    snespad_log_t host_log, decoded_log;
+    buffer_t text = { NULL, 0, 0 };
+    uint16_t n;
+    bool ok;
+
+    snespad_sim_init(&sim, 1, 0, 2, 3, 4);
+    snespad_sim_attach(&sim, 0, kind);
+    snespad_init(&host, 1, 0, 2, 3, 4);
+    snespad_set_bus(&host, snespad_sim_bus(&sim));
+    snespad_log_init(&host_log, host_buf, sizeof(host_buf));
+    snespad_set_record(&host, &host_log);
+    snespad_trace_init(&trace);
+    snespad_set_trace(&host, &trace);
+    snespad_trace_vcd_begin(&vcd, buffer_write, &text);
+
+    snespad_begin(&host);
+    snespad_sim_advance(&sim, 100);
+    snespad_start(&host);
+    for (int i = 0; i < polls; i++) {
+        if (kind == SNESPAD_SIM_MOUSE || kind == SNESPAD_SIM_HYPERKIN) {
+            snespad_sim_mouse_move(&sim, 0, (i % 7) - 3, (i % 5) - 2);
+            if (i == 10) {
+                snespad_set_mouse_speed(&host, SNES_MOUSE_MEDIUM);
+            }
+        }
+        if (kind == SNESPAD_SIM_KEYBOARD && i % 3 == 0) {
+            snespad_sim_key(&sim, 0, typing[(i / 3) % sizeof(typing)]);
+        }
+        if (kind == SNESPAD_SIM_PAD && i == polls / 2) {
+            snespad_set_rumble(&host, 0x80, 0x30);
+        }
+        snespad_sim_set_buttons(&sim, 0, (uint16_t)((i * 37) & SNES_BUTTONS));
+
+        snespad_poll(&host);
+        while ((n = snespad_trace_drain(&trace, batch, 64))) {
+            snespad_trace_vcd_write(&vcd, batch, n);
+        }
+        snespad_sim_advance(&sim, 16000);
+    }
+    snespad_trace_vcd_end(&vcd);
+    snespad_log_flush(&host_log);
+
+    // Parse the dump back and decode it like the sniffer does
+    d.issues = 0;
+    d.bus.now_us = decoder_now_us;
+    d.bus.ctx = &d;
+    snespad_init(&d.pad, 1, 0, 2, 3, 4);
+    snespad_set_bus(&d.pad, &d.bus);
+    snespad_log_init(&decoded_log, decoded_buf, sizeof(decoded_buf));
+    snespad_set_record(&d.pad, &decoded_log);
+    snespad_capture_init(&d.cap, SNESPAD_CAPTURE_VCD);
+    snespad_capture_set_handlers(&d.cap, on_frame, on_issue, &d);
+    snespad_capture_feed(&d.cap, (const char*)text.data, text.len);
+    snespad_capture_end(&d.cap);
+    snespad_log_flush(&decoded_log);
+
+    ok = trace.dropped == 0 && d.issues == 0 && d.cap.errors == 0 && !host_log.overflow &&
+         decoded_log.len == host_log.len && !memcmp(decoded_buf, host_buf, host_log.len);
+
+    printf("%-10s %4u frames  %7zu VCD bytes  dropped %u  issues %u  log %s\n", name,
+           d.cap.frames, text.len, trace.dropped, d.issues,
+           decoded_log.len == host_log.len && !memcmp(decoded_buf, host_buf, host_log.len) ?
+           "same" : "DIFFERS");
+
+    free(text.data);
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    int polls = argc > 1 ? atoi(argv[1]) : 120;
+    bool ok = true;
+
+    ok &= check_kind(SNESPAD_SIM_PAD, "controller", polls);
+    ok &= check_kind(SNESPAD_SIM_NES, "nes", polls);
+    ok &= check_kind(SNESPAD_SIM_MOUSE, "mouse", polls);
+    ok &= check_kind(SNESPAD_SIM_HYPERKIN, "hyperkin", polls);
+    ok &= check_kind(SNESPAD_SIM_KEYBOARD, "keyboard", polls);
+
+    printf(ok ? "trace round trip ok\n" : "trace round trip FAILED\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,150 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Host micro-benchmark for the multi-port decode step: per-bit gathering
+  (the dat |= bit << i loop used for a single port) against the portable
+  byte-tile and word-parallel bit matrix transposes, for 1 to 16 ports. See README.md in this directory for the build line.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "snespad_group.h"
+
+#define SETS        256        // distinct sample sets cycled through
+#define ITERATIONS  200000
+#define RUNS        5
+
+static uint32_t samples[SETS][32];
+static volatile uint32_t sink;
+
+static uint32_t rng = 0x12345678;
+
+static uint32_t next_random(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Per-bit gather for each port's data pin
+static void decode_loop(const uint32_t in[32], uint32_t out[32], int ports)
+{
+    for (int p = 0; p < ports; p++) {
+        uint32_t dat = 0;
+        for (int i = 0; i < 32; i++) {
+            dat |= ((in[i] >> p) & 1) << i;
+        }
+        out[p] = dat;
+    }
+}
+
+static void decode_bytes(const uint32_t in[32], uint32_t out[32], int ports)
+{
+    (void)ports;
+    memcpy(out, in, 32 * sizeof(uint32_t));
+    snespad_transpose32_bytes(out);
+}
+
+static void decode_word(const uint32_t in[32], uint32_t out[32], int ports)
+{
+    (void)ports;
+    memcpy(out, in, 32 * sizeof(uint32_t));
+    snespad_transpose32(out);
+}
+
+typedef void (*decode_fn)(const uint32_t in[32], uint32_t out[32], int ports);
+
+// Best of several runs, in ns per decode
+static double run(decode_fn fn, int ports)
+{
+    uint32_t out[32];
+    double best = 0;
+
+    for (int r = 0; r < RUNS; r++) {
+        uint32_t acc = 0;
+        double start = now_ns();
+        double ns;
+
+        for (int n = 0; n < ITERATIONS; n++) {
+            fn(samples[n % SETS], out, ports);
+            acc += out[n % ports];
+        }
+        sink = acc;
+
+        ns = (now_ns() - start) / ITERATIONS;
+        if (r == 0 || ns < best) best = ns;
+    }
+
+    return best;
+}
+
+static int verify(void)
+{
+    uint32_t ref[32], out[32];
+
+    for (int s = 0; s < SETS; s++) {
+        decode_loop(samples[s], ref, 32);
+
+        decode_bytes(samples[s], out, 32);
+        if (memcmp(ref, out, sizeof(ref))) return 0;
+
+        decode_word(samples[s], out, 32);
+        if (memcmp(ref, out, sizeof(ref))) return 0;
+    }
+
+    return 1;
+}
+
+int main(void)
+{
+    static const int port_counts[] = { 1, 2, 4, 5, 6, 8, 16 };
+
+    for (int s = 0; s < SETS; s++) {
+        for (int i = 0; i < 32; i++) {
+            samples[s][i] = next_random();
+        }
+    }
+
+    if (!verify()) {
+        printf("transpose mismatch\n");
+        return 1;
+    }
+
+    printf("ports  per-bit(ns)  bytes(ns)  word(ns)\n");
+    for (unsigned c = 0; c < sizeof(port_counts) / sizeof(port_counts[0]); c++) {
+        int ports = port_counts[c];
+
+        printf("%5d  %11.1f  %9.1f  %8.1f\n", ports,
+               run(decode_loop, ports), run(decode_bytes, ports), run(decode_word, ports));
+    }
+
+    return 0;
+}
@@ -26,59 +26,26 @@
 
 #ifndef _SNESPAD_H_
 #define _SNESPAD_H_
-#endif
+
 #include <inttypes.h>
 // Try to include Arduino.h
 #ifdef ARDUINO
     #include <Arduino.h>
-#else
+#elif !defined(SNESPAD_HOST)
     // If we aren't compiling on Arduino, include the Pico SDK standard library
     #include "pico/stdlib.h"
 #endif
 
-#ifndef SNES_PAD_DEBUG
-#define SNES_PAD_DEBUG      0
-#endif
-
-#define SNES_PAD_NONE      -1
-#define SNES_PAD_CONTROLLER 0
-#define SNES_PAD_NES        1
-#define SNES_PAD_MOUSE      2
-#define SNES_PAD_KEYBOARD   3
+#include "snespad_c.h"
 
-#define SNES_B              0x01       // 0b0000000000000000 0000000000000001
-#define SNES_Y              0x02       // 0b0000000000000000 0000000000000010
-#define SNES_SELECT         0x04       // 0b0000000000000000 0000000000000100
-#define SNES_START          0x08       // 0b0000000000000000 0000000000001000
-#define SNES_UP             0x10       // 0b0000000000000000 0000000000010000
-#define SNES_DOWN           0x20       // 0b0000000000000000 0000000000100000
-#define SNES_LEFT           0x40       // 0b0000000000000000 0000000001000000
-#define SNES_RIGHT          0x80       // 0b0000000000000000 0000000010000000
-#define SNES_A              0x100      // 0b0000000000000000 0000000100000000
-#define SNES_X              0x200      // 0b0000000000000000 0000001000000000
-#define SNES_L              0x400      // 0b0000000000000000 0000010000000000
-#define SNES_R              0x800      // 0b0000000000000000 0000100000000000
-#define SNES_DEVICE_ID      0xF000     // 0b0000000000000000 1111000000000000
-#define SNES_MOUSE_SPEED    0xC00      // 0b0000000000000000 0000110000000000
-#define SNES_MOUSE_Y_SIGN   0x10000    // 0b0000000000000001 0000000000000000
-#define SNES_MOUSE_Y        0xFE0000   // 0b0000000011111110 0000000000000000
-#define SNES_MOUSE_X_SIGN   0x1000000  // 0b0000000100000000 0000000000000000
-#define SNES_MOUSE_X        0xFE000000 // 0b1111111000000000 0000000000000000
-
-#define SNES_PAD_ID         0x00
-#define SNES_MOUSE_ID       0x08
-#define SNES_KEYBOARD_ID    0x78 // Xband Keyboard ID (within keyboardRead)
-
-#define SNES_MOUSE_SLOW     0
-#define SNES_MOUSE_MEDIUM   2
-#define SNES_MOUSE_FAST     1
-
-#define SNES_MOUSE_THRESHOLD 10  // max speed fails (Hyperkin compatiblity)
-#define SNES_MOUSE_PRECISION 1   // mouse movement velocity multiplier
+#define SNES_PAD_NONE      SNESPAD_NONE
+#define SNES_PAD_CONTROLLER SNESPAD_CONTROLLER
+#define SNES_PAD_NES        SNESPAD_NES
+#define SNES_PAD_MOUSE      SNESPAD_MOUSE
+#define SNES_PAD_KEYBOARD   SNESPAD_KEYBOARD
 
 // SNES Xband Keyboard Scancodes
-#define SNES_KEY_RELEASE    0xf0 // scancode: next key released
-#define SNES_KEY_SPECIAL    0xe0 // scancode: next key special
+// (release/special prefixes and special keys are in snespad_c.h)
 
 // Normal Key Scancodes Table
 // column 0xh
@@ -191,50 +158,7 @@
 #define SNES_KEY_JOY_SELECT 0x8C
 #define SNES_KEY_JOY_START  0x8D
 
-// Special Key Scancodes
-#define SNES_KEY_RETURN     0x5a // JOY-A?
-#define SNES_KEY_LEFT       0x6b
-#define SNES_KEY_DOWN       0x72
-#define SNES_KEY_RIGHT      0x74
-#define SNES_KEY_UP         0x75
-
-// Arduino Keyboard.h Lib Keycodes
-#ifndef KEY_LEFT_CTRL
-#define KEY_LEFT_CTRL       0x80
-#define KEY_LEFT_SHIFT      0x81
-#define KEY_LEFT_ALT        0x82
-#define KEY_LEFT_GUI        0x83
-#define KEY_RIGHT_SHIFT     0x85
-#define KEY_RIGHT_GUI       0x87
-#define KEY_RETURN          0xb0
-#define KEY_ESC             0xb1
-#define KEY_BACKSPACE       0xb2
-#define KEY_TAB             0xb3
-#define KEY_CAPS_LOCK       0xc1
-#define KEY_F1              0xc2
-#define KEY_F2              0xc3
-#define KEY_F3              0xc4
-#define KEY_F4              0xc5
-#define KEY_F5              0xc6
-#define KEY_F6              0xc7
-#define KEY_F7              0xc8
-#define KEY_F8              0xc9
-#define KEY_F9              0xca
-#define KEY_F10             0xcb
-#define KEY_F11             0xcc
-#define KEY_F12             0xcd
-
-#define KEY_UP_ARROW        0xda
-#define KEY_DOWN_ARROW      0xd9
-#define KEY_LEFT_ARROW      0xd8
-#define KEY_RIGHT_ARROW     0xd7
-#endif
-
-typedef struct {
-    const char* key_string; // String representation of the key
-    uint8_t hid_keycode; // HID keyboard keycode
-    bool releasable; // Keys that get a released scancode
-} XbandKeyMapping;
+typedef snespad_key_mapping_t XbandKeyMapping;
 
 class SNESpad {
   protected:
@@ -245,6 +169,10 @@ class SNESpad {
     uint16_t mouseX        = 0;
     uint16_t mouseY        = 0;
 
+    uint16_t buttons       = 0; // held buttons (SNES_* masks)
+    uint16_t pressed       = 0; // went down during the last poll
+    uint16_t released      = 0; // went up during the last poll
+
     bool buttonA         = false;
     bool buttonB         = false;
     bool buttonX         = false;
@@ -269,223 +197,31 @@ class SNESpad {
     void begin();
   	void start();
   	void poll();
-    XbandKeyMapping getKeyFromScancode(uint8_t scancode, bool special);
+    bool pollStep(); // non-blocking poll, true when a packet completed
+    void setBus(const snespad_bus_t* bus); // replace GPIO transport (call before begin)
+    void setEventQueue(snespad_event_queue_t* queue, uint8_t port = 0); // push input events
+    void setSnapshot(snespad_snapshot_slot_t* slot); // publish state for other cores/ISRs
+    void setKeyboard(snespad_keyboard_t* keyboard); // decode scancodes into key changes
+    void setMotion(snespad_motion_t* motion); // accumulate mouse motion across polls
+    void setMouseSpeed(uint8_t speed); // SNES_MOUSE_SLOW, SNES_MOUSE_MEDIUM or SNES_MOUSE_FAST
+    void setRecord(snespad_log_t* log); // log every packet read
+    void setReplay(snespad_log_t* log); // read packets from a log instead of the bus
+    void setTiming(int8_t deviceType, const snespad_timing_t* timing); // per device bus timing
+    bool calibrate(const snespad_calibration_t* cfg = nullptr); // find fastest safe timing
+    XbandKeyMapping getKeyFromScancode(uint8_t scancode, bool special); // links key names
+    static uint8_t getHidKeycode(uint8_t scancode, bool special); // keycode only
     bool setCapsLockLed(bool enabled);
+#if SNESPAD_STATS
+    bool getLatency(int8_t deviceType, snespad_latency_t* latency) const; // latch to publish latency
+    void resetLatency();
+#endif
+#if SNESPAD_TRACE
+    void setTrace(snespad_trace_t* trace); // record driven edges and samples
+#endif
   private:
-	
-    uint8_t latchPin; // output: latch
-    uint8_t clockPin; // output: clock
-    uint8_t data0Pin;  // input:  data0
-    uint8_t data1Pin;  // input:  data1
-    uint8_t iobitPin;  // input:  select
-    uint8_t mouseSpeed;   // mouse speed (0=SLOW|1=MEDIUM|2=FAST)
-    uint8_t mouseSpeedFails = 0;
-    uint32_t _lastRead;
-    bool capsLocked = false; // xband keyboard capslock state
+    snespad_t pad; // C driver state (pins, bus, protocol state)
 
-    XbandKeyMapping keyMapping[16][10] = {
-        // 0xh, 1xh, 2xh, 3xh, 4xh, 5xh, 6xh, 7xh, 8xh, 9xh
-        {
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"NUM-0", '0'},
-          {"OpenX", KEY_LEFT_GUI, 1},
-          {"90h", 0}
-        }, // x0h
-        {
-          {"F1", KEY_F1},
-          {"Alt", KEY_LEFT_ALT, 1},
-          {"C", 'c'},
-          {"N", 'n'},
-          {",<", ','},
-          {"unused", 0},
-          {"unused", 0},
-          {"NUM-.", '.'},
-          {"ClosedX", KEY_RIGHT_GUI, 1},
-          {"91h", 0}
-        }, // x1h
-        {
-          {"F2", KEY_F2},
-          {"LShft", KEY_LEFT_SHIFT, 1},
-          {"X", 'x'},
-          {"B", 'b'},
-          {"K", 'k'},
-          {"\",", '\''},
-          {"unused", 0},
-          {"NUM-2", '2'},
-          {"unused", 0},
-          {"92h", 0}
-        }, // x2h
-        {
-          {"F3", KEY_F3},
-          {"unused", 0},
-          {"D", 'd'},
-          {"H", 'h'},
-          {"I", 'i'},
-          {"unused", 0},
-          {"unused", 0},
-          {"NUM-5", '5'},
-          {"unused", 0},
-          {"93h", 0}
-        }, // x3h
-        {
-          {"F4", KEY_F4},
-          {"LCtl", KEY_LEFT_CTRL, 1},
-          {"E", 'e'},
-          {"G", 'g'},
-          {"O", 'o'},
-          {"[{", '['},
-          {"unused", 0},
-          {"NUM-6", '6'},
-          {"NUM-SUB", 0},
-          {"94h", 0}
-        }, // x4h
-        {
-          {"F5", KEY_F5},
-          {"Q", 'q'},
-          {"4$", '4'},
-          {"Y", 'y'},
-          {"0)", '0'},
-          {"=+", '='},
-          {"unused", 0},
-          {"NUM-8", '8'},
-          {"unused", 0},
-          {"95h", 0}
-        }, // x5h
-        {
-          {"F6", KEY_F6},
-          {"1!", '1'},
-          {"3#", '3'},
-          {"6^", '6'},
-          {"9(", '9'},
-          {"unused", 0},
-          {"BACKSPACE", KEY_BACKSPACE},
-          {"ESC", KEY_ESC},
-          {"JOY-A", 0},
-          {"96h", 0}
-        }, // x6h
-        {
-          {"F7", KEY_F7},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"NUM-DIV", 0},
-          {"JOY-B", 0},
-          {"97h", 0}
-        }, // x7h
-        {
-          {"F8", KEY_F8},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"CAPS", KEY_CAPS_LOCK, 1},
-          {"unused", 0},
-          {"unused", 0},
-          {"JOY-X", 0},
-          {"98h", 0}
-        }, // x8h
-        {
-          {"F9", KEY_F9},
-          {"unused", 0},
-          {"SPACE", ' '},
-          {"unused", 0},
-          {".>", '.'},
-          {"RShft", KEY_RIGHT_SHIFT, 1},
-          {"NUM-1", '1'},
-          {"NUM-RET", 0},
-          {"JOY-Y", 0},
-          {"99h", 0}
-        }, // x9h
-        {
-          {"F10", KEY_F10},
-          {"Z", 'z'},
-          {"V", 'v'},
-          {"M", 'm'},
-          {"/?", '/'},
-          {"ENTER", KEY_RETURN},
-          {"unused", 0},
-          {"NUM-3", '3'},
-          {"JOY-L", 0},
-          {"9Ah", 0}
-        }, // xAh
-        {
-          {"F11", KEY_F11},
-          {"S", 's'},
-          {"F", 'f'},
-          {"J", 'j'},
-          {"L", 'l'},
-          {"]}", ']'},
-          {"NUM-4", '4'},
-          {"unused", 0},
-          {"JOY-R", 0},
-          {"9Bh", 0}
-        }, // xBh
-        {
-          {"F12", KEY_F12},
-          {"A", 'a'},
-          {"T", 't'},
-          {"U", 'u'},
-          {";:", ';'},
-          {"unused", 0},
-          {"NUM-7", '7'},
-          {"NUM-ADD", '+'},
-          {"SELECT", 0},
-          {"9Ch", 0}
-        }, // xCh
-        {
-          {"Switch", KEY_TAB},
-          {"W", 'w'},
-          {"R", 'r'},
-          {"7&", '7'},
-          {"P", 'p'},
-          {"\\", '\\'},
-          {"unused", 0},
-          {"NUM-9", '9'},
-          {"START", 0},
-          {"9Dh", 0}
-        }, // xDh
-        {
-          {"`~", '`'},
-          {"2@", '2'},
-          {"5%", '5'},
-          {"8*", '8'},
-          {"-_", '-'},
-          {"unused", 0},
-          {"unused", 0},
-          {"NUM-MUL", '*'},
-          {"8Eh", 0},
-          {"unused", 0},
-        }, // xEh
-        {
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"unused", 0},
-          {"8Fh", 0},
-          {"unused", 0},
-        }, // xFh
-    };
-
-    void init();
-    void latch();
-    uint32_t read();
-    uint32_t clock(uint8_t dat0Pin, uint8_t dat1Pin);
-    uint32_t clock(uint8_t datPin);
-    void setMouseSpeed(); // check and set mouse speed
-    bool readKeyboard(bool readonlyID);
-    uint8_t reverse(uint8_t c);
-    void handleScancodes();
+    void sync(); // copy driver state into public members
 };
+
+#endif // _SNESPAD_H_
@@ -26,510 +26,675 @@
 */
 
 #include "snespad_c.h"
-
-#ifdef ARDUINO
-#include "Arduino.h"
-#else
-#include "pico/stdlib.h"
-#endif
+#include "snespad_internal.h"
+#include <stddef.h>
 
 #if SNES_PAD_DEBUG
 #include <stdio.h>
 #endif
 
 // ============================================================================
-// Xband Keyboard Mapping Table
+// Internal Functions
 // ============================================================================
-// Maps scancodes to key names and HID keycodes
-// Indexed by [scancode & 0x0F][(scancode & 0xF0) >> 4]
-
-static const snespad_key_mapping_t key_mapping[16][10] = {
-    // 0xh, 1xh, 2xh, 3xh, 4xh, 5xh, 6xh, 7xh, 8xh, 9xh
-    {
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"NUM-0", '0', 0},
-        {"OpenX", KEY_LEFT_GUI, 1},
-        {"90h", 0, 0}
-    }, // x0h
-    {
-        {"F1", KEY_F1, 0},
-        {"Alt", KEY_LEFT_ALT, 1},
-        {"C", 'c', 0},
-        {"N", 'n', 0},
-        {",<", ',', 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"NUM-.", '.', 0},
-        {"ClosedX", KEY_RIGHT_GUI, 1},
-        {"91h", 0, 0}
-    }, // x1h
-    {
-        {"F2", KEY_F2, 0},
-        {"LShft", KEY_LEFT_SHIFT, 1},
-        {"X", 'x', 0},
-        {"B", 'b', 0},
-        {"K", 'k', 0},
-        {"\"'", '\'', 0},
-        {"unused", 0, 0},
-        {"NUM-2", '2', 0},
-        {"unused", 0, 0},
-        {"92h", 0, 0}
-    }, // x2h
-    {
-        {"F3", KEY_F3, 0},
-        {"unused", 0, 0},
-        {"D", 'd', 0},
-        {"H", 'h', 0},
-        {"I", 'i', 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"NUM-5", '5', 0},
-        {"unused", 0, 0},
-        {"93h", 0, 0}
-    }, // x3h
-    {
-        {"F4", KEY_F4, 0},
-        {"LCtl", KEY_LEFT_CTRL, 1},
-        {"E", 'e', 0},
-        {"G", 'g', 0},
-        {"O", 'o', 0},
-        {"[{", '[', 0},
-        {"unused", 0, 0},
-        {"NUM-6", '6', 0},
-        {"NUM-SUB", 0, 0},
-        {"94h", 0, 0}
-    }, // x4h
-    {
-        {"F5", KEY_F5, 0},
-        {"Q", 'q', 0},
-        {"4$", '4', 0},
-        {"Y", 'y', 0},
-        {"0)", '0', 0},
-        {"=+", '=', 0},
-        {"unused", 0, 0},
-        {"NUM-8", '8', 0},
-        {"unused", 0, 0},
-        {"95h", 0, 0}
-    }, // x5h
-    {
-        {"F6", KEY_F6, 0},
-        {"1!", '1', 0},
-        {"3#", '3', 0},
-        {"6^", '6', 0},
-        {"9(", '9', 0},
-        {"unused", 0, 0},
-        {"BACKSPACE", KEY_BACKSPACE, 0},
-        {"ESC", KEY_ESC, 0},
-        {"JOY-A", 0, 0},
-        {"96h", 0, 0}
-    }, // x6h
-    {
-        {"F7", KEY_F7, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"NUM-DIV", 0, 0},
-        {"JOY-B", 0, 0},
-        {"97h", 0, 0}
-    }, // x7h
-    {
-        {"F8", KEY_F8, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"CAPS", KEY_CAPS_LOCK, 1},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"JOY-X", 0, 0},
-        {"98h", 0, 0}
-    }, // x8h
-    {
-        {"F9", KEY_F9, 0},
-        {"unused", 0, 0},
-        {"SPACE", ' ', 0},
-        {"unused", 0, 0},
-        {".>", '.', 0},
-        {"RShft", KEY_RIGHT_SHIFT, 1},
-        {"NUM-1", '1', 0},
-        {"NUM-RET", 0, 0},
-        {"JOY-Y", 0, 0},
-        {"99h", 0, 0}
-    }, // x9h
-    {
-        {"F10", KEY_F10, 0},
-        {"Z", 'z', 0},
-        {"V", 'v', 0},
-        {"M", 'm', 0},
-        {"/?", '/', 0},
-        {"ENTER", KEY_RETURN, 0},
-        {"unused", 0, 0},
-        {"NUM-3", '3', 0},
-        {"JOY-L", 0, 0},
-        {"9Ah", 0, 0}
-    }, // xAh
-    {
-        {"F11", KEY_F11, 0},
-        {"S", 's', 0},
-        {"F", 'f', 0},
-        {"J", 'j', 0},
-        {"L", 'l', 0},
-        {"]}", ']', 0},
-        {"NUM-4", '4', 0},
-        {"unused", 0, 0},
-        {"JOY-R", 0, 0},
-        {"9Bh", 0, 0}
-    }, // xBh
-    {
-        {"F12", KEY_F12, 0},
-        {"A", 'a', 0},
-        {"T", 't', 0},
-        {"U", 'u', 0},
-        {";:", ';', 0},
-        {"unused", 0, 0},
-        {"NUM-7", '7', 0},
-        {"NUM-ADD", '+', 0},
-        {"SELECT", 0, 0},
-        {"9Ch", 0, 0}
-    }, // xCh
-    {
-        {"Switch", KEY_TAB, 0},
-        {"W", 'w', 0},
-        {"R", 'r', 0},
-        {"7&", '7', 0},
-        {"P", 'p', 0},
-        {"\\", '\\', 0},
-        {"unused", 0, 0},
-        {"NUM-9", '9', 0},
-        {"START", 0, 0},
-        {"9Dh", 0, 0}
-    }, // xDh
-    {
-        {"`~", '`', 0},
-        {"2@", '2', 0},
-        {"5%", '5', 0},
-        {"8*", '8', 0},
-        {"-_", '-', 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"NUM-MUL", '*', 0},
-        {"8Eh", 0, 0},
-        {"unused", 0, 0}
-    }, // xEh
-    {
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"unused", 0, 0},
-        {"8Fh", 0, 0},
-        {"unused", 0, 0}
-    }  // xFh
-};
 
-// ============================================================================
-// Platform Abstraction
-// ============================================================================
+// Initialize GPIO pins
+static void snespad_gpio_init(snespad_t* pad)
+{
+    const snespad_bus_t* bus = pad->bus;
+
+    bus->pin_mode(bus->ctx, pad->clock_pin, SNESPAD_PIN_OUTPUT);
+    bus->pin_mode(bus->ctx, pad->latch_pin, SNESPAD_PIN_OUTPUT);
+    bus->pin_mode(bus->ctx, pad->data0_pin, SNESPAD_PIN_INPUT_PULLUP);
+    bus->pin_mode(bus->ctx, pad->data1_pin, SNESPAD_PIN_INPUT_PULLUP);
+    bus->pin_mode(bus->ctx, pad->iobit_pin, SNESPAD_PIN_OUTPUT);
+}
 
-static inline void delay_us(unsigned int delay_value)
+// Verify the device and determine its type from a completed read
+static uint32_t snespad_read_result(snespad_t* pad, uint32_t dat, bool disconnected, bool is_keyboard)
 {
-#ifdef ARDUINO
-    delayMicroseconds(delay_value);
-#else
-    busy_wait_us(delay_value);
+    dat = ~dat;  // Controller buttons are active low, so invert bits
+
+    // Verify controller or mouse is connected
+    if (!is_keyboard && disconnected && !(dat & 0xFFFF)) {
+        pad->type = SNESPAD_NONE;
+        pad->mouse_speed = 0;
+        pad->mouse_speed_pulses = 0;
+        pad->mouse_speed_fails = 0;
+        pad->mouse_speed_unsupported = false;
+        return 0;
+    }
+
+    // Check device type id
+    bool is_snes = ((dat & SNES_DEVICE_ID) >> 12) == SNES_PAD_ID;
+    bool is_mouse = ((dat & SNES_DEVICE_ID) >> 12) == SNES_MOUSE_ID;
+    bool is_nes = ~dat && ((dat >> 8) & 0xFF) == 0xFF;
+
+    // Determine device type
+    if (is_keyboard) {
+        pad->type = SNESPAD_KEYBOARD;
+    } else if (is_snes) {
+        pad->type = SNESPAD_CONTROLLER;
+    } else if (is_nes) {
+        pad->type = SNESPAD_NES;
+    } else if (is_mouse) {
+        uint8_t last_mouse_speed = pad->mouse_speed;
+
+        // Parse mouse speed bits
+        pad->mouse_speed = ((dat & SNES_MOUSE_SPEED) >> 10);
+        if (pad->mouse_speed > 2) {
+            pad->mouse_speed = 0;
+        }
+
+        // Detect mice that ignore speed pulses (Hyperkin)
+        if (pad->mouse_speed_pulses) {
+            if (pad->mouse_speed != last_mouse_speed) {
+                pad->mouse_speed_fails = 0;
+            } else if (++pad->mouse_speed_fails >= SNES_MOUSE_THRESHOLD) {
+                pad->mouse_speed_unsupported = true;
+            }
+            pad->mouse_speed_pulses = 0;
+        }
+
+        pad->type = SNESPAD_MOUSE;
+    } else {
+        pad->type = SNESPAD_NONE;
+
+#if SNES_PAD_DEBUG
+        printf("UNKNOWN device\n");
 #endif
+    }
+
+    return dat;
 }
 
-static inline void gpio_write(uint8_t pin, uint8_t value)
+// Push an event stamped with the current transfer's latch time
+static void snespad_emit(snespad_t* pad, uint8_t type, uint16_t code, int16_t dx, int16_t dy)
 {
-#ifdef ARDUINO
-    digitalWrite(pin, value ? HIGH : LOW);
-#else
-    gpio_put(pin, value ? 1 : 0);
-#endif
+    snespad_event_t event;
+
+    event.time_us = pad->xfer.latch_us;
+    event.type = type;
+    event.port = pad->event_port;
+    event.code = code;
+    event.dx = dx;
+    event.dy = dy;
+    snespad_event_push(pad->events, &event);
 }
 
-static inline uint8_t gpio_read(uint8_t pin)
+// One event per button that changed
+static void snespad_emit_buttons(snespad_t* pad, uint16_t changed, uint16_t buttons)
 {
-#ifdef ARDUINO
-    return digitalRead(pin);
-#else
-    return gpio_get(pin);
-#endif
+    for (uint16_t mask = 1; changed; mask <<= 1) {
+        if (changed & mask) {
+            snespad_emit(pad, (buttons & mask) ? SNESPAD_EVENT_BUTTON_DOWN : SNESPAD_EVENT_BUTTON_UP, mask, 0, 0);
+            changed &= ~mask;
+        }
+    }
 }
 
-// ============================================================================
-// Internal Functions
-// ============================================================================
+// The decoder keyboard scancodes go through: the one set with
+// snespad_set_keyboard(), or the pad's own
+static snespad_keyboard_t* snespad_key_decoder(snespad_t* pad)
+{
+    return pad->keyboard ? pad->keyboard : &pad->key_decoder;
+}
 
-// Initialize GPIO pins
-static void snespad_gpio_init(snespad_t* pad)
+// Key down/up events from the decoder's changes
+static void snespad_emit_key_changes(snespad_t* pad)
 {
-#ifdef ARDUINO
-    pinMode(pad->clock_pin, OUTPUT);
-    pinMode(pad->latch_pin, OUTPUT);
-    pinMode(pad->data0_pin, INPUT);
-    pinMode(pad->data1_pin, INPUT);
-    pinMode(pad->iobit_pin, OUTPUT);
-
-    digitalWrite(pad->data0_pin, HIGH);  // pull_up
-    digitalWrite(pad->data1_pin, HIGH);
-#else
-    gpio_init(pad->clock_pin);
-    gpio_init(pad->latch_pin);
-    gpio_init(pad->data0_pin);
-    gpio_init(pad->data1_pin);
-    gpio_init(pad->iobit_pin);
-
-    gpio_set_dir(pad->clock_pin, GPIO_OUT);
-    gpio_set_dir(pad->latch_pin, GPIO_OUT);
-    gpio_set_dir(pad->data0_pin, GPIO_IN);
-    gpio_pull_up(pad->data0_pin);
-    gpio_set_dir(pad->data1_pin, GPIO_IN);
-    gpio_pull_up(pad->data1_pin);
-    gpio_set_dir(pad->iobit_pin, GPIO_OUT);
-#endif
+    const snespad_keyboard_t* keyboard = snespad_key_decoder(pad);
+
+    for (uint8_t i = 0; i < keyboard->changes_len; i++) {
+        uint16_t change = keyboard->changes[i];
+
+        snespad_emit(pad, (change & SNESPAD_KEY_RELEASED) ? SNESPAD_EVENT_KEY_UP : SNESPAD_EVENT_KEY_DOWN,
+                     change & ~SNESPAD_KEY_RELEASED, 0, 0);
+    }
 }
 
-// Signal mouse to change speed
-static void snespad_set_mouse_speed(snespad_t* pad)
+// Run the last read's scancodes through the keyboard decoder
+static void snespad_decode_keys(snespad_t* pad)
 {
-    if (pad->type == SNESPAD_MOUSE &&
-        pad->mouse_speed_fails < SNES_MOUSE_THRESHOLD &&
-        pad->mouse_speed != SNES_MOUSE_FAST) {
+    snespad_keyboard_t* keyboard = snespad_key_decoder(pad);
 
-        gpio_write(pad->clock_pin, 0);
-        delay_us(6);
+    snespad_keyboard_decode(keyboard, pad->scancodes, pad->scancodes_len);
+    if (keyboard->caps_led) {
+        pad->caps_locked = keyboard->caps_locked;
+    }
 
-        gpio_write(pad->clock_pin, 1);
-        delay_us(12);
+    if (pad->events) {
+        snespad_emit_key_changes(pad);
     }
 }
 
-// Clock in a single data bit (and shift out rumble data on IOBit)
-static uint32_t snespad_clock_bit(snespad_t* pad, uint8_t data_pin)
+// Release the decoder's held keys (device lost or replaced)
+static void snespad_release_keys(snespad_t* pad)
 {
-    uint32_t ret;
+    uint8_t n;
 
-    // Set IOBit for rumble data BEFORE clock pulse
-    if (pad->rumble_active) {
-        gpio_write(pad->iobit_pin, (pad->rumble_frame >> pad->rumble_bit_pos) & 1);
-        if (pad->rumble_bit_pos == 0) {
-            pad->rumble_bit_pos = 15;  // Wrap for continuous sending
-        } else {
-            pad->rumble_bit_pos--;
+    do {
+        n = snespad_keyboard_release_all(snespad_key_decoder(pad));
+        if (pad->events) {
+            snespad_emit_key_changes(pad);
         }
+    } while (n == SNESPAD_KEY_CHANGES_MAX);
+}
+
+// Update the held buttons, accumulating edges until the next poll starts
+static void snespad_set_buttons(snespad_t* pad, uint16_t buttons)
+{
+    uint16_t changed = buttons ^ pad->buttons;
+
+    if (changed && pad->events) {
+        snespad_emit_buttons(pad, changed, buttons);
     }
 
-    gpio_write(pad->clock_pin, 0);
-    delay_us(12);
+    pad->pressed |= buttons & ~pad->buttons;
+    pad->released |= pad->buttons & ~buttons;
+    pad->buttons = buttons;
+
+    pad->button_a =        (buttons & SNES_A) != 0;
+    pad->button_b =        (buttons & SNES_B) != 0;
+    pad->button_x =        (buttons & SNES_X) != 0;
+    pad->button_y =        (buttons & SNES_Y) != 0;
+    pad->button_start =    (buttons & SNES_START) != 0;
+    pad->button_select =   (buttons & SNES_SELECT) != 0;
+    pad->button_l =        (buttons & SNES_L) != 0;
+    pad->button_r =        (buttons & SNES_R) != 0;
+
+    pad->direction_up =    (buttons & SNES_UP) != 0;
+    pad->direction_down =  (buttons & SNES_DOWN) != 0;
+    pad->direction_left =  (buttons & SNES_LEFT) != 0;
+    pad->direction_right = (buttons & SNES_RIGHT) != 0;
+}
 
-    ret = gpio_read(data_pin);
+void snespad_clear_edges(snespad_t* pad)
+{
+    pad->pressed = 0;
+    pad->released = 0;
 
-    gpio_write(pad->clock_pin, 1);
-    delay_us(12);
+    snespad_key_decoder(pad)->changes_len = 0;
+}
 
-    return ret;
+// Reset state after a device is detected
+static void snespad_reset_state(snespad_t* pad)
+{
+    pad->mouse_x = 0;
+    pad->mouse_y = 0;
+
+    snespad_set_buttons(pad, 0);
+    snespad_release_keys(pad);
 }
 
-// Clock in data0/data1 dibits (for keyboard)
-static uint32_t snespad_clock_dibit(snespad_t* pad)
+// Update button/axis state from a packet
+static void snespad_decode(snespad_t* pad, int32_t state)
 {
-    uint32_t ret;
+    snespad_input_t input;
 
-    gpio_write(pad->clock_pin, 0);
-    delay_us(12);
+    snespad_decode_packet(pad->type, state, &input);
 
-    ret = gpio_read(pad->data0_pin) | ((gpio_read(pad->data1_pin) & 1) << 1);
+    switch (pad->type) {
+        case SNESPAD_CONTROLLER:
+        case SNESPAD_NES:
+            snespad_set_buttons(pad, input.buttons);
+            break;
 
-    gpio_write(pad->clock_pin, 1);
-    delay_us(12);
+        case SNESPAD_MOUSE: {
+            // Center position [0-255], the axis bits are twice the count
+            int x = 127 + input.dx * 2 * SNES_MOUSE_PRECISION;
+            int y = 127 + input.dy * 2 * SNES_MOUSE_PRECISION;
 
-    return ret;
-}
+            pad->mouse_x = x;
+            pad->mouse_y = y;
 
-// Latch to start read
-static void snespad_latch(snespad_t* pad)
-{
-    gpio_write(pad->latch_pin, 1);
-    delay_us(12);
+            if (pad->motion) {
+                snespad_motion_add(pad->motion, input.dx, input.dy);
+            }
+
+            if (pad->events && (x != 127 || y != 127)) {
+                snespad_emit(pad, SNESPAD_EVENT_MOUSE_MOVE, 0, x - 127, y - 127);
+            }
+
+            snespad_set_buttons(pad, input.buttons);
+            break;
+        }
 
-    snespad_set_mouse_speed(pad);
+        case SNESPAD_KEYBOARD:
+            // Keyboard scancodes were already read in snespad_read()
+            snespad_decode_keys(pad);
+            break;
 
-    gpio_write(pad->latch_pin, 0);
-    delay_us(12);
+        default:
+            break;
+    }
+
+#if SNES_PAD_DEBUG
+    if (pad->last_read != (uint32_t)state) {
+        printf("A:%d B:%d X:%d Y:%d L:%d R:%d Sel:%d Start:%d ",
+               pad->button_a, pad->button_b, pad->button_x, pad->button_y,
+               pad->button_l, pad->button_r, pad->button_select, pad->button_start);
+        printf("Mouse X:%d Y:%d", pad->mouse_x, pad->mouse_y);
+    }
+    pad->last_read = state;
+#endif
 }
 
-// Reverse bits within a byte (e.g., 0b1000 -> 0b0001)
-static uint8_t snespad_reverse_byte(uint8_t c)
+// Append the transfer just read to the record log (before x->dat is inverted)
+static void snespad_record_xfer(snespad_t* pad)
 {
-    uint8_t r = 0;
-    for (int i = 0; i < 8; i++) {
-        r <<= 1;
-        r |= c & 1;
-        c >>= 1;
+    const snespad_xfer_t* x = &pad->xfer;
+    snespad_log_record_t record;
+
+    record.time_us = x->latch_us;
+    record.packet = x->dat;
+    record.type = pad->type;
+    record.disconnected = x->disconnected;
+    record.keyboard = x->kid == SNES_KEYBOARD_ID;
+    record.scancodes_len = pad->scancodes_len;
+    for (uint8_t i = 0; i < 16; i++) {
+        record.scancodes[i] = pad->scancodes[i];
     }
-    return r;
+    snespad_log_write(pad->record, &record);
 }
 
-// Read keyboard data
-static bool snespad_read_keyboard(snespad_t* pad, bool readonly_id)
+// Load the next recorded transfer in place of a bus read
+static void snespad_replay_xfer(snespad_t* pad)
 {
-    uint8_t kid = 0;
-    uint8_t num = 0;
-    uint8_t i, n;
+    snespad_xfer_t* x = &pad->xfer;
+    snespad_log_record_t record;
+
+    if (!snespad_log_read(pad->replay, &record)) {
+        // End of the log: an empty port
+        record.time_us = x->latch_us;
+        record.packet = 0xFFFFFFFF;
+        record.disconnected = true;
+        record.keyboard = false;
+        record.scancodes_len = 0;
+        for (uint8_t i = 0; i < 16; i++) {
+            record.scancodes[i] = 0;
+        }
+    }
 
-    // Activate the keyboard's host comm interrupt routine
-    gpio_write(pad->iobit_pin, 0);
+    // Same speed bookkeeping as a bus read, so Hyperkin detection replays too
+    pad->mouse_speed_pulses = snespad_mouse_speed_pulses(pad);
+    x->latch_us = record.time_us;
+    x->dat = record.packet;
+    x->disconnected = record.disconnected;
+    x->kid = record.keyboard ? SNES_KEYBOARD_ID : 0;
+    pad->scancodes_len = record.scancodes_len;
+    for (uint8_t i = 0; i < 16; i++) {
+        pad->scancodes[i] = record.scancodes[i];
+    }
+    x->phase = XFER_DONE;
+}
 
-    // Read the 8 bits (4 clocks) keyboard signature (id)
-    for (i = 0; i < 8; i += 2) {
-        uint32_t bits = snespad_clock_dibit(pad);
-        kid |= bits << i;
+void snespad_xfer_begin(snespad_t* pad, uint8_t mode)
+{
+    snespad_xfer_t* x = &pad->xfer;
 
-        if (i == 0 && readonly_id) {
-            gpio_write(pad->iobit_pin, 1);  // KeyboardID read only (no scancodes)
-        }
+    x->mode = mode;
+    x->phase = XFER_LATCH_HIGH;
+    x->dat = 0;
+    x->readonly_id = false;
+    x->wait_us = 0;
+}
 
-        // Auto recover common out of sync packet transaction
-        if (i == 4 && kid == (SNES_KEYBOARD_ID >> 2)) {
-            kid = kid << 2;
-            break;
+void snespad_rumble_bit(snespad_t* pad)
+{
+    // Set IOBit for rumble data BEFORE clock pulse
+    if (pad->rumble_active) {
+        uint8_t bit = (pad->rumble_frame >> pad->rumble_bit_pos) & 1;
+
+        gpio_write(pad, pad->iobit_pin, bit);
+        TRACE_DRIVE(pad, SNESPAD_LINE_IOBIT, bit);
+        if (pad->rumble_bit_pos == 0) {
+            pad->rumble_bit_pos = 15;  // Wrap for continuous sending
+        } else {
+            pad->rumble_bit_pos--;
         }
     }
+}
 
-    // Can toggle caps lock after reading id
-    if (!pad->caps_locked) {
-        gpio_write(pad->iobit_pin, 1);  // Toggle Caps Lock LED
+bool snespad_xfer_complete(snespad_t* pad)
+{
+    snespad_xfer_t* x = &pad->xfer;
+    uint32_t packet;
+    int8_t lost;
+
+    STATS_TIME(pad, sampled_us);
+
+    x->phase = XFER_IDLE;
+    lost = pad->type;
+    packet = snespad_read_result(pad, x->dat, x->disconnected, x->kid == SNES_KEYBOARD_ID);
+    if (pad->record) {
+        snespad_record_xfer(pad);
     }
+    x->dat = packet;
 
-    // Read the 4 bits (2 clocks) upcoming scancode byte count (0-15)
-    for (i = 0; i < 4; i += 2) {
-        uint32_t bits = snespad_clock_dibit(pad);
-        num |= bits << i;
+    switch (x->mode) {
+        case XFER_MODE_START:
+#if SNES_PAD_DEBUG
+            printf("Data Packet: 0x%08X\n", (unsigned int)packet);
+#endif
+            if (pad->type != SNESPAD_NONE) {
+#if SNES_PAD_DEBUG
+                printf("Device Type: %d\n", pad->type);
+#endif
+                snespad_reset_state(pad);
+                if (pad->events) {
+                    snespad_emit(pad, SNESPAD_EVENT_ATTACH, pad->type, 0, 0);
+                }
+            }
+#if SNES_PAD_DEBUG
+            else {
+                printf("Unknown Device.\n");
+            }
+#endif
+            break;
+
+        case XFER_MODE_POLL:
+            if (packet) {
+                // Swapped for a different device between polls
+                if (pad->type != lost) {
+                    snespad_release_keys(pad);
+                }
+                if (pad->events && pad->type != lost) {
+                    snespad_emit(pad, SNESPAD_EVENT_DETACH, (uint8_t)lost, 0, 0);
+                    snespad_emit(pad, SNESPAD_EVENT_ATTACH, pad->type, 0, 0);
+                }
+                snespad_decode(pad, (int32_t)packet);
+#if SNESPAD_STATS
+                STATS_TIME(pad, decoded_us);
+                pad->stats.last.latch_us = x->latch_us;
+                pad->stats.pending = true;
+#endif
+            } else {
+                // Device disconnected or invalid read
+                pad->type = SNESPAD_NONE;
+                snespad_set_buttons(pad, 0);
+                snespad_release_keys(pad);
+                if (pad->events) {
+                    snespad_emit(pad, SNESPAD_EVENT_DETACH, (uint8_t)lost, 0, 0);
+                }
+                return true;
+            }
+            break;
+
+        default:
+            break;
     }
-    num = num & 0x0F;
 
-    // Auto recover random bad ids
-    if (pad->type == SNESPAD_KEYBOARD && kid == SNES_KEYBOARD_ID + 1) {
-        kid = SNES_KEYBOARD_ID;
+    return false;
+}
+
+// Transfer complete: a poll that lost its device re-runs detection
+// Returns true if a follow-up transfer was started.
+static bool snespad_xfer_finish(snespad_t* pad)
+{
+    if (!snespad_xfer_complete(pad)) {
+        return false;
     }
 
-    // Read the scancodes
-    for (i = 0; i < 16; i++) {
-        pad->scancodes[i] = 0;
+#if SNES_PAD_DEBUG
+    printf("snespad_start\n");
+#endif
+    snespad_xfer_begin(pad, XFER_MODE_START);
+    return true;
+}
+
+void snespad_kb_dibit(snespad_t* pad, uint8_t bits)
+{
+    snespad_xfer_t* x = &pad->xfer;
+
+    if (x->stage == KB_STAGE_ID) {
+        x->kid |= bits << x->index;
+    } else if (x->stage == KB_STAGE_COUNT) {
+        x->num |= bits << x->index;
+    } else {
+        x->byte |= bits << x->index;
     }
+    x->index += 2;
+}
+
+void snespad_kb_next(snespad_t* pad)
+{
+    snespad_xfer_t* x = &pad->xfer;
 
-    if (!readonly_id && num && kid == SNES_KEYBOARD_ID) {
-        for (n = 0; n < num; n++) {
-            uint8_t read_byte = 0;
+    x->phase = XFER_KB_LOW;
 
-            for (i = 0; i < 8; i += 2) {
-                uint32_t bits = snespad_clock_dibit(pad);
-                read_byte |= bits << i;
+    switch (x->stage) {
+        case KB_STAGE_ID:
+            if (x->index == 2 && x->readonly_id) {
+                gpio_write(pad, pad->iobit_pin, 1);  // KeyboardID read only (no scancodes)
+                TRACE_DRIVE(pad, SNESPAD_LINE_IOBIT, 1);
             }
 
-            pad->scancodes[n] = read_byte;
-        }
+            // Auto recover common out of sync packet transaction
+            if (x->index == 6 && x->kid == (SNES_KEYBOARD_ID >> 2)) {
+                x->kid = x->kid << 2;
+                x->index = 8;
+            }
+            if (x->index < 8) return;
+
+            // Can toggle caps lock after reading id
+            if (!pad->caps_locked) {
+                gpio_write(pad, pad->iobit_pin, 1);  // Toggle Caps Lock LED
+                TRACE_DRIVE(pad, SNESPAD_LINE_IOBIT, 1);
+            }
+
+            // Read the 4 bits (2 clocks) upcoming scancode byte count (0-15)
+            x->stage = KB_STAGE_COUNT;
+            x->index = 0;
+            return;
+
+        case KB_STAGE_COUNT:
+            if (x->index < 4) return;
+
+            x->num &= 0x0F;
+
+            // Auto recover random bad ids
+            if (pad->type == SNESPAD_KEYBOARD && x->kid == SNES_KEYBOARD_ID + 1) {
+                x->kid = SNES_KEYBOARD_ID;
+            }
+
+            // Read the scancodes
+            for (uint8_t i = 0; i < 16; i++) {
+                pad->scancodes[i] = 0;
+            }
+
+            if (!x->readonly_id && x->num && x->kid == SNES_KEYBOARD_ID) {
+                x->stage = KB_STAGE_DATA;
+                x->index = 0;
+                x->n = 0;
+                x->byte = 0;
+                return;
+            }
+            break;
+
+        case KB_STAGE_DATA:
+            if (x->index < 8) return;
+
+            pad->scancodes[x->n++] = x->byte;
+            x->byte = 0;
+            x->index = 0;
+            if (x->n < x->num) return;
+            break;
     }
 
     // End keyboard read
-    gpio_write(pad->iobit_pin, 1);
-    pad->scancodes_len = num;
+    gpio_write(pad, pad->iobit_pin, 1);
+    TRACE_DRIVE(pad, SNESPAD_LINE_IOBIT, 1);
+    pad->scancodes_len = x->num;
 
 #if SNES_PAD_DEBUG
-    printf("KB_ID:0x%02X SCANCODES: %d\n", kid, num);
+    printf("KB_ID:0x%02X SCANCODES: %d\n", x->kid, x->num);
 #endif
 
-    return kid == SNES_KEYBOARD_ID;
+    x->phase = XFER_DONE;
 }
 
-// Read device data
-static uint32_t snespad_read(snespad_t* pad)
+// Perform the current transfer phase and select the next one
+// Sets xfer.wait_us to how long the bus must hold before the next phase.
+// Returns false once the transfer (and any follow-up) is complete.
+static bool snespad_xfer_advance(snespad_t* pad)
 {
-    uint32_t dat = 0;
-    bool readonly_id = false;
+    snespad_xfer_t* x = &pad->xfer;
+    const snespad_timing_t* t = snespad_timing(pad);
+    uint32_t bits;
 
-    // A connected device will pull the data line low prior to latch
-    // A disconnected pin is kept high by internal pull_up
-    uint32_t disconnected = gpio_read(pad->data0_pin);
+    TRACE_WAIT(pad, x->wait_us);
+    x->wait_us = 0;
 
-    // Normal 16-bit (or 32-bit for mouse) controller read
-    snespad_latch(pad);
-    for (uint8_t i = 0; i < 32; i++) {
-        uint32_t bit = snespad_clock_bit(pad, pad->data0_pin);
-        dat |= bit << i;
+    switch (x->phase) {
+        case XFER_LATCH_HIGH:
+            if (pad->replay) {
+                snespad_replay_xfer(pad);
+                break;
+            }
 
-        if (i == 15) {
-            bool read_extra = !bit;  // Check if mouse
-            if (!read_extra) break;  // Skip extra bytes if not
-            delay_us(12);
-        }
-    }
+            // A connected device will pull the data line low prior to latch
+            // A disconnected pin is kept high by internal pull_up
+            x->disconnected = gpio_read(pad, pad->data0_pin);
+            if (SNESPAD_STATS || TRACE_ON(pad) || pad->events || pad->snapshot || pad->record) {
+                x->latch_us = bus_now_us(pad);
+            }
+            TRACE_SYNC(pad, x->latch_us);
+            TRACE_SAMPLE(pad, SNESPAD_LINE_DATA0, x->disconnected ? SNESPAD_LINE_DATA0 : 0);
+
+            // Latch to start read
+            gpio_write(pad, pad->latch_pin, 1);
+            TRACE_DRIVE(pad, SNESPAD_LINE_LATCH, 1);
+            x->wait_us = t->latch_us;
+            x->index = pad->mouse_speed_pulses = snespad_mouse_speed_pulses(pad);
+            x->phase = x->index ? XFER_SPEED_LOW : XFER_LATCH_LOW;
+            break;
 
-    // Check and read keyboard
-    bool is_keyboard = snespad_read_keyboard(pad, readonly_id);
+        case XFER_SPEED_LOW:
+            // Signal mouse to change speed
+            gpio_write(pad, pad->clock_pin, 0);
+            TRACE_DRIVE(pad, SNESPAD_LINE_CLOCK, 0);
+            x->wait_us = t->clock_low_us > 1 ? t->clock_low_us / 2 : 1;
+            x->phase = XFER_SPEED_HIGH;
+            break;
 
-    dat = ~dat;  // Controller buttons are active low, so invert bits
+        case XFER_SPEED_HIGH:
+            gpio_write(pad, pad->clock_pin, 1);
+            TRACE_DRIVE(pad, SNESPAD_LINE_CLOCK, 1);
+            x->wait_us = t->clock_high_us;
+            x->phase = --x->index ? XFER_SPEED_LOW : XFER_LATCH_LOW;
+            break;
 
-    // Verify controller or mouse is connected
-    if (!is_keyboard && disconnected && !(dat & 0xFFFF)) {
-        pad->type = SNESPAD_NONE;
-        pad->mouse_speed_fails = 0;
-        pad->mouse_speed = 0;
-        return 0;
-    }
+        case XFER_LATCH_LOW:
+            gpio_write(pad, pad->latch_pin, 0);
+            TRACE_DRIVE(pad, SNESPAD_LINE_LATCH, 0);
+            x->wait_us = t->latch_us;
+            x->index = 0;
+            x->phase = XFER_BIT_LOW;
+            break;
 
-    // Check device type id
-    bool is_snes = ((dat & SNES_DEVICE_ID) >> 12) == SNES_PAD_ID;
-    bool is_mouse = ((dat & SNES_DEVICE_ID) >> 12) == SNES_MOUSE_ID;
-    bool is_nes = ~dat && ((dat >> 8) & 0xFF) == 0xFF;
+        case XFER_BIT_LOW:
+            snespad_rumble_bit(pad);
+            gpio_write(pad, pad->clock_pin, 0);
+            TRACE_DRIVE(pad, SNESPAD_LINE_CLOCK, 0);
+            x->wait_us = t->sample_us;
+            x->phase = XFER_BIT_SAMPLE;
+            break;
 
-    // Determine device type
-    if (is_keyboard) {
-        pad->type = SNESPAD_KEYBOARD;
-    } else if (is_snes) {
-        pad->type = SNESPAD_CONTROLLER;
-    } else if (is_nes) {
-        pad->type = SNESPAD_NES;
-    } else if (is_mouse) {
-        uint8_t last_mouse_speed = pad->mouse_speed;
+        case XFER_BIT_SAMPLE:
+            // Normal 16-bit (or 32-bit for mouse) controller read
+            bits = gpio_read(pad, pad->data0_pin);
+            TRACE_SAMPLE(pad, SNESPAD_LINE_DATA0, (uint8_t)(bits << 2));
+            x->dat |= bits << x->index;
+            x->wait_us = t->clock_low_us > t->sample_us ? t->clock_low_us - t->sample_us : 0;
+            x->phase = XFER_BIT_HIGH;
+            break;
 
-        // Parse mouse speed bits
-        pad->mouse_speed = ((dat & SNES_MOUSE_SPEED) >> 10);
-        if (pad->mouse_speed > 2) {
-            pad->mouse_speed = 0;
-        }
+        case XFER_BIT_HIGH:
+            gpio_write(pad, pad->clock_pin, 1);
+            TRACE_DRIVE(pad, SNESPAD_LINE_CLOCK, 1);
+            x->wait_us = t->clock_high_us;
+            x->phase = XFER_BIT_LOW;
+
+            if (x->index == 15) {
+                bool read_extra = !((x->dat >> 15) & 1);  // Check if mouse
+                if (read_extra) {
+                    x->wait_us += t->clock_high_us;
+                } else {
+                    x->phase = XFER_KB_START;  // Skip extra bytes if not
+                }
+            } else if (x->index == 31) {
+                x->phase = XFER_KB_START;
+            }
+            x->index++;
+            break;
 
-        // Detect Hyperkin mouse failure to change speed
-        if (pad->mouse_speed != SNES_MOUSE_FAST &&
-            last_mouse_speed == pad->mouse_speed &&
-            pad->mouse_speed_fails < SNES_MOUSE_THRESHOLD) {
-            pad->mouse_speed_fails++;
-        }
+        case XFER_KB_START:
+            // Check and read keyboard
+            // Activate the keyboard's host comm interrupt routine
+            gpio_write(pad, pad->iobit_pin, 0);
+            TRACE_DRIVE(pad, SNESPAD_LINE_IOBIT, 0);
+
+            // Read the 8 bits (4 clocks) keyboard signature (id)
+            x->stage = KB_STAGE_ID;
+            x->index = 0;
+            x->kid = 0;
+            x->num = 0;
+            x->phase = XFER_KB_LOW;
+            break;
 
-        pad->type = SNESPAD_MOUSE;
-    } else {
-        pad->type = SNESPAD_NONE;
+        case XFER_KB_LOW:
+            gpio_write(pad, pad->clock_pin, 0);
+            TRACE_DRIVE(pad, SNESPAD_LINE_CLOCK, 0);
+            x->wait_us = t->sample_us;
+            x->phase = XFER_KB_SAMPLE;
+            break;
 
-#if SNES_PAD_DEBUG
-        printf("UNKNOWN device\n");
-#endif
+        case XFER_KB_SAMPLE:
+            // Clock in data0/data1 dibits
+            bits = gpio_read(pad, pad->data0_pin) | ((gpio_read(pad, pad->data1_pin) & 1) << 1);
+            TRACE_SAMPLE(pad, SNESPAD_LINE_DATA0 | SNESPAD_LINE_DATA1, (uint8_t)(bits << 2));
+            snespad_kb_dibit(pad, bits);
+            x->wait_us = t->clock_low_us > t->sample_us ? t->clock_low_us - t->sample_us : 0;
+            x->phase = XFER_KB_HIGH;
+            break;
+
+        case XFER_KB_HIGH:
+            gpio_write(pad, pad->clock_pin, 1);
+            TRACE_DRIVE(pad, SNESPAD_LINE_CLOCK, 1);
+            x->wait_us = t->clock_high_us;
+            x->phase = XFER_KB_NEXT;
+            break;
+
+        case XFER_KB_NEXT:
+            snespad_kb_next(pad);
+            break;
+
+        case XFER_DONE:
+            return snespad_xfer_finish(pad);
+
+        default:
+            return false;
     }
 
-    return dat;
+    return true;
+}
+
+// Run the current transfer to completion, busy-waiting between phases
+static void snespad_xfer_run(snespad_t* pad)
+{
+    while (snespad_xfer_advance(pad)) {
+        if (pad->xfer.wait_us) {
+            delay_us(pad, pad->xfer.wait_us);
+        }
+    }
+}
+
+// Read device data (blocking)
+static uint32_t snespad_read(snespad_t* pad)
+{
+    snespad_xfer_begin(pad, XFER_MODE_READ);
+    snespad_xfer_run(pad);
+    return pad->xfer.dat;
 }
 
 // ============================================================================
@@ -545,8 +710,33 @@ void snespad_init(snespad_t* pad, uint8_t clock, uint8_t latch,
     pad->data1_pin = data1;
     pad->iobit_pin = iobit;
 
+    pad->bus = snespad_bus_platform();
+
     pad->type = SNESPAD_NONE;
 
+    pad->buttons = 0;
+    pad->pressed = 0;
+    pad->released = 0;
+
+    // The built-in decoder leaves the Caps Lock LED to snespad_set_caps_lock_led()
+    snespad_keyboard_init(&pad->key_decoder);
+    pad->key_decoder.caps_led = false;
+    pad->events = NULL;
+    pad->event_port = 0;
+    pad->snapshot = NULL;
+    pad->keyboard = NULL;
+    pad->motion = NULL;
+    pad->record = NULL;
+    pad->replay = NULL;
+#if SNESPAD_TRACE
+    pad->trace = NULL;
+#endif
+    pad->xfer.latch_us = 0;
+
+#if SNESPAD_STATS
+    snespad_reset_latency(pad);
+#endif
+
     pad->button_a = false;
     pad->button_b = false;
     pad->button_x = false;
@@ -564,7 +754,10 @@ void snespad_init(snespad_t* pad, uint8_t clock, uint8_t latch,
     pad->mouse_x = 0;
     pad->mouse_y = 0;
     pad->mouse_speed = 0;
+    pad->mouse_speed_target = SNES_MOUSE_FAST;
+    pad->mouse_speed_pulses = 0;
     pad->mouse_speed_fails = 0;
+    pad->mouse_speed_unsupported = false;
 
     pad->scancodes_len = 0;
     pad->caps_locked = false;
@@ -579,8 +772,66 @@ void snespad_init(snespad_t* pad, uint8_t clock, uint8_t latch,
     for (int i = 0; i < 16; i++) {
         pad->scancodes[i] = 0;
     }
+
+    pad->xfer.phase = 0;  // idle
+    pad->xfer.deadline_us = 0;
+
+    for (int i = 0; i < 5; i++) {
+        pad->timing[i].latch_us = SNES_TIMING_DEFAULT_US;
+        pad->timing[i].clock_low_us = SNES_TIMING_DEFAULT_US;
+        pad->timing[i].clock_high_us = SNES_TIMING_DEFAULT_US;
+        pad->timing[i].sample_us = SNES_TIMING_DEFAULT_US;
+    }
+}
+
+void snespad_set_bus(snespad_t* pad, const snespad_bus_t* bus)
+{
+    pad->bus = bus;
+}
+
+void snespad_set_event_queue(snespad_t* pad, snespad_event_queue_t* queue, uint8_t port)
+{
+    pad->events = queue;
+    pad->event_port = port;
+}
+
+void snespad_set_snapshot(snespad_t* pad, snespad_snapshot_slot_t* slot)
+{
+    pad->snapshot = slot;
+}
+
+void snespad_set_keyboard(snespad_t* pad, snespad_keyboard_t* keyboard)
+{
+    pad->keyboard = keyboard;
+}
+
+void snespad_set_mouse_speed(snespad_t* pad, uint8_t speed)
+{
+    pad->mouse_speed_target = speed;
 }
 
+void snespad_set_motion(snespad_t* pad, snespad_motion_t* motion)
+{
+    pad->motion = motion;
+}
+
+void snespad_set_record(snespad_t* pad, snespad_log_t* log)
+{
+    pad->record = log;
+}
+
+void snespad_set_replay(snespad_t* pad, snespad_log_t* log)
+{
+    pad->replay = log;
+}
+
+#if SNESPAD_TRACE
+void snespad_set_trace(snespad_t* pad, snespad_trace_t* trace)
+{
+    pad->trace = trace;
+}
+#endif
+
 void snespad_begin(snespad_t* pad)
 {
     snespad_gpio_init(pad);
@@ -592,190 +843,99 @@ void snespad_begin(snespad_t* pad)
 
 void snespad_start(snespad_t* pad)
 {
-    uint32_t packet;
-
 #if SNES_PAD_DEBUG
     printf("snespad_start\n");
 #endif
 
     pad->type = SNESPAD_NONE;
 
-    packet = snespad_read(pad);
-    (void)packet;  // Packet used only for type detection in read()
-
-#if SNES_PAD_DEBUG
-    printf("Data Packet: 0x%08X\n", packet);
-#endif
-
-    if (pad->type != SNESPAD_NONE) {
-#if SNES_PAD_DEBUG
-        printf("Device Type: %d\n", pad->type);
-#endif
-        // Reset state
-        pad->mouse_x = 0;
-        pad->mouse_y = 0;
-
-        pad->button_a = false;
-        pad->button_b = false;
-        pad->button_x = false;
-        pad->button_y = false;
-        pad->button_start = false;
-        pad->button_select = false;
-        pad->button_l = false;
-        pad->button_r = false;
-
-        pad->direction_up = false;
-        pad->direction_down = false;
-        pad->direction_left = false;
-        pad->direction_right = false;
-    }
-#if SNES_PAD_DEBUG
-    else {
-        printf("Unknown Device.\n");
-    }
-#endif
+    snespad_clear_edges(pad);
+    snespad_xfer_begin(pad, XFER_MODE_START);
+    snespad_xfer_run(pad);
+    snespad_poll_done(pad);
 }
 
 void snespad_poll(snespad_t* pad)
 {
-    int32_t state = 0;
-
 #if SNES_PAD_DEBUG
     printf("snespad_poll: ");
 #endif
 
-    if (pad->type != SNESPAD_NONE) {
-        state = snespad_read(pad);
-
-        if (state) {
-            switch (pad->type) {
-                case SNESPAD_CONTROLLER:
-                    pad->direction_left =  (state & SNES_LEFT) != 0;
-                    pad->direction_up =    (state & SNES_UP) != 0;
-                    pad->direction_right = (state & SNES_RIGHT) != 0;
-                    pad->direction_down =  (state & SNES_DOWN) != 0;
-
-                    pad->button_select = (state & SNES_SELECT) != 0;
-                    pad->button_start =  (state & SNES_START) != 0;
-                    pad->button_b =      (state & SNES_B) != 0;
-                    pad->button_y =      (state & SNES_Y) != 0;
-                    pad->button_a =      (state & SNES_A) != 0;
-                    pad->button_x =      (state & SNES_X) != 0;
-                    pad->button_l =      (state & SNES_L) != 0;
-                    pad->button_r =      (state & SNES_R) != 0;
-                    break;
-
-                case SNESPAD_NES:
-                    pad->direction_left =  (state & SNES_LEFT) != 0;
-                    pad->direction_up =    (state & SNES_UP) != 0;
-                    pad->direction_right = (state & SNES_RIGHT) != 0;
-                    pad->direction_down =  (state & SNES_DOWN) != 0;
-
-                    pad->button_select = (state & SNES_SELECT) != 0;
-                    pad->button_start =  (state & SNES_START) != 0;
-                    pad->button_b =      (state & SNES_Y) != 0;  // NES B is at SNES Y position
-                    pad->button_a =      (state & SNES_B) != 0;  // NES A is at SNES B position
-                    break;
-
-                case SNESPAD_MOUSE: {
-                    int x = 127;  // Center position [0-255]
-                    int y = 127;
-
-                    // Mouse X axis
-                    x = (state & SNES_MOUSE_X) >> 25;
-                    x = snespad_reverse_byte(x) * SNES_MOUSE_PRECISION;
-                    if (state & SNES_MOUSE_X_SIGN) {
-                        x = 127 - x;
-                    } else {
-                        x = 127 + x;
-                    }
-
-                    // Mouse Y axis
-                    y = (state & SNES_MOUSE_Y) >> 17;
-                    y = snespad_reverse_byte(y) * SNES_MOUSE_PRECISION;
-                    if (state & SNES_MOUSE_Y_SIGN) {
-                        y = 127 - y;
-                    } else {
-                        y = 127 + y;
-                    }
-
-                    pad->mouse_x = x;
-                    pad->mouse_y = y;
-                    pad->button_b = (state & SNES_X) != 0;
-                    pad->button_a = (state & SNES_A) != 0;
-                    break;
-                }
-
-                case SNESPAD_KEYBOARD:
-                    // Keyboard scancodes were already read in snespad_read()
-                    break;
-
-                default:
-                    break;
-            }
+    // Finish a transfer started by snespad_poll_step(), or run a new one
+    if (pad->xfer.phase == XFER_IDLE) {
+        snespad_clear_edges(pad);
+        snespad_xfer_begin(pad, pad->type != SNESPAD_NONE ? XFER_MODE_POLL : XFER_MODE_START);
+    } else {
+        // Let the hold of the phase in progress run out first
+        int32_t left = (int32_t)(pad->xfer.deadline_us - bus_now_us(pad));
 
-#if SNES_PAD_DEBUG
-            if (pad->last_read != (uint32_t)state) {
-                printf("A:%d B:%d X:%d Y:%d L:%d R:%d Sel:%d Start:%d ",
-                       pad->button_a, pad->button_b, pad->button_x, pad->button_y,
-                       pad->button_l, pad->button_r, pad->button_select, pad->button_start);
-                printf("Mouse X:%d Y:%d", pad->mouse_x, pad->mouse_y);
-            }
-            pad->last_read = state;
-#endif
-        } else {
-            // Device disconnected or invalid read
-            pad->type = SNESPAD_NONE;
-            snespad_start(pad);
+        if (left > 0) {
+            delay_us(pad, (uint32_t)left);
         }
-    } else {
-        snespad_start(pad);
     }
+    snespad_xfer_run(pad);
+    snespad_poll_done(pad);
 
 #if SNES_PAD_DEBUG
     printf("\n");
 #endif
 }
 
-snespad_key_mapping_t snespad_get_key_from_scancode(uint8_t scancode, bool special)
+bool snespad_poll_step(snespad_t* pad)
 {
-    snespad_key_mapping_t key = {"unused", 0, 0};
+    snespad_xfer_t* x = &pad->xfer;
 
-    if (special) {
-        // Special scancodes (preceded by SNES_KEY_SPECIAL scancode)
-        switch (scancode) {
-            case SNES_KEY_RETURN:
-                key.key_string = "JOY-A";
-                key.hid_keycode = KEY_RETURN;
-                key.releasable = true;
-                break;
-            case SNES_KEY_LEFT:
-                key.key_string = "LEFT";
-                key.hid_keycode = KEY_LEFT_ARROW;
-                key.releasable = true;
-                break;
-            case SNES_KEY_DOWN:
-                key.key_string = "DOWN";
-                key.hid_keycode = KEY_DOWN_ARROW;
-                key.releasable = true;
-                break;
-            case SNES_KEY_RIGHT:
-                key.key_string = "RIGHT";
-                key.hid_keycode = KEY_RIGHT_ARROW;
-                key.releasable = true;
-                break;
-            case SNES_KEY_UP:
-                key.key_string = "UP";
-                key.hid_keycode = KEY_UP_ARROW;
-                key.releasable = true;
-                break;
+    if (x->phase == XFER_IDLE) {
+        snespad_clear_edges(pad);
+        snespad_xfer_begin(pad, pad->type != SNESPAD_NONE ? XFER_MODE_POLL : XFER_MODE_START);
+    } else if ((int32_t)(bus_now_us(pad) - x->deadline_us) < 0) {
+        return false;  // current phase is still holding the bus
+    }
+
+    while (snespad_xfer_advance(pad)) {
+        if (x->wait_us) {
+            x->deadline_us = bus_now_us(pad) + x->wait_us;
+            return false;
         }
-    } else {
-        // Normal scancodes
-        key = key_mapping[(scancode & 0x0F)][((scancode & 0xF0) >> 4)];
     }
 
-    return key;
+    snespad_poll_done(pad);
+    return true;
+}
+
+void snespad_poll_done(snespad_t* pad)
+{
+#if SNESPAD_STATS
+    snespad_stats_publish(pad);
+#endif
+
+    if (pad->snapshot) {
+        snespad_snapshot_t snap;
+
+        snap.time_us = pad->xfer.latch_us;
+        snap.type = pad->type;
+        snap.buttons = pad->buttons;
+        snap.pressed = pad->pressed;
+        snap.released = pad->released;
+        snap.mouse_x = pad->mouse_x;
+        snap.mouse_y = pad->mouse_y;
+        for (uint8_t i = 0; i < 16; i++) {
+            snap.scancodes[i] = pad->scancodes[i];
+        }
+        snap.scancodes_len = pad->scancodes_len;
+
+        snespad_snapshot_write(pad->snapshot, &snap);
+    }
+}
+
+bool snespad_poll_busy(const snespad_t* pad)
+{
+    return pad->xfer.phase != XFER_IDLE;
+}
+
+uint32_t snespad_poll_deadline(const snespad_t* pad)
+{
+    return pad->xfer.deadline_us;
 }
 
 void snespad_set_caps_lock_led(snespad_t* pad, bool enabled)
@@ -803,3 +963,261 @@ void snespad_set_rumble(snespad_t* pad, uint8_t left, uint8_t right)
     // If both motors off, send one final frame with zeros to clear
     // (rumble_active stays true so the zero-frame gets clocked out)
 }
+
+void snespad_set_timing(snespad_t* pad, int8_t type, const snespad_timing_t* timing)
+{
+    if (type < SNESPAD_NONE || type > SNESPAD_KEYBOARD) return;
+
+    pad->timing[type + 1] = *timing;
+    if (pad->timing[type + 1].sample_us > timing->clock_low_us) {
+        pad->timing[type + 1].sample_us = timing->clock_low_us;
+    }
+}
+
+void snespad_get_timing(const snespad_t* pad, int8_t type, snespad_timing_t* timing)
+{
+    if (type < SNESPAD_NONE || type > SNESPAD_KEYBOARD) return;
+
+    *timing = pad->timing[type + 1];
+}
+
+// Bits compared between calibration reads (motion and speed bits vary)
+static uint32_t snespad_calibration_mask(int8_t type)
+{
+    switch (type) {
+        case SNESPAD_CONTROLLER: return 0x0000FFFF;
+        case SNESPAD_NES:        return 0xFFFFFFFF;
+        case SNESPAD_MOUSE:      return 0x0000F3FF;
+        default:                 return 0;  // keyboard: device type only
+    }
+}
+
+// Read once with the given profile, keeping the detected type untouched
+static uint32_t snespad_calibration_read(snespad_t* pad, int8_t type,
+                                         const snespad_timing_t* timing, int8_t* read_type)
+{
+    snespad_timing_t saved = pad->timing[type + 1];
+    uint32_t packet;
+
+    pad->timing[type + 1] = *timing;
+    packet = snespad_read(pad);
+    pad->timing[type + 1] = saved;
+
+    *read_type = pad->type;
+    pad->type = type;
+
+    return packet & snespad_calibration_mask(type);
+}
+
+bool snespad_calibrate(snespad_t* pad, const snespad_calibration_t* cfg)
+{
+    static const snespad_calibration_t defaults = {1, 1, 8, 25};
+    snespad_timing_t reference;
+    snespad_timing_t candidate;
+    uint8_t fastest;
+    uint8_t half;
+    int8_t type;
+
+    if (!cfg) cfg = &defaults;
+
+    if (pad->type == SNESPAD_NONE) {
+        snespad_start(pad);
+    }
+    type = pad->type;
+    if (type == SNESPAD_NONE) return false;
+
+    reference = pad->timing[type + 1];
+    fastest = reference.clock_low_us;
+    if (reference.clock_high_us > fastest) fastest = reference.clock_high_us;
+    if (reference.latch_us > fastest) fastest = reference.latch_us;
+
+    for (half = fastest; half >= cfg->min_us + cfg->step_us && cfg->step_us; ) {
+        uint8_t passed = 0;
+        uint8_t attempts = 0;
+
+        half -= cfg->step_us;
+        candidate.latch_us = half;
+        candidate.clock_low_us = half;
+        candidate.clock_high_us = half;
+        candidate.sample_us = half;
+
+        // Bracket each fast read with reads at the known-good rate so
+        // button changes during calibration are not mistaken for errors
+        while (passed < cfg->reads && attempts < cfg->reads * 4) {
+            int8_t type_before, type_fast, type_after;
+            uint32_t before = snespad_calibration_read(pad, type, &reference, &type_before);
+            uint32_t fast = snespad_calibration_read(pad, type, &candidate, &type_fast);
+            uint32_t after = snespad_calibration_read(pad, type, &reference, &type_after);
+
+            attempts++;
+            if (before != after || type_before != type || type_after != type) {
+                continue;  // input changed (or reference read failed), retry
+            }
+            if (fast != before || type_fast != type) {
+                break;
+            }
+            passed++;
+        }
+
+        if (passed < cfg->reads) break;
+        fastest = half;
+    }
+
+    // Settle on the fastest passing rate plus margin (rounded up)
+    half = (uint8_t)(((uint16_t)fastest * (100 + cfg->margin_pct) + 99) / 100);
+
+    candidate.latch_us = half < reference.latch_us ? half : reference.latch_us;
+    candidate.clock_low_us = half < reference.clock_low_us ? half : reference.clock_low_us;
+    candidate.clock_high_us = half < reference.clock_high_us ? half : reference.clock_high_us;
+    candidate.sample_us = candidate.clock_low_us;
+    pad->timing[type + 1] = candidate;
+
+#if SNES_PAD_DEBUG
+    printf("snespad_calibrate: type %d half-period %dus\n", type, half);
+#endif
+
+    return true;
+}
+
+// ============================================================================
+// Latency Statistics
+// ============================================================================
+
+#if SNESPAD_STATS
+
+// Histogram bucket: 0-3 exact, then 4 buckets per power of two
+static uint8_t snespad_latency_bucket(uint32_t us)
+{
+    uint8_t n = 2;
+
+    if (us < 4) {
+        return us;
+    }
+
+    while (n < 31 && (us >> (n + 1))) {
+        n++;
+    }
+
+    if (n > 16) {
+        return SNESPAD_STATS_BUCKETS - 1;
+    }
+
+    return 4 * (n - 1) + ((us >> (n - 2)) & 3);
+}
+
+// Largest latency that falls in a bucket
+static uint32_t snespad_latency_bucket_max(uint8_t bucket)
+{
+    uint8_t n;
+
+    if (bucket < 4) {
+        return bucket;
+    }
+
+    n = bucket / 4 + 1;
+    return ((uint32_t)(4 + (bucket & 3) + 1) << (n - 2)) - 1;
+}
+
+void snespad_latency_add(snespad_latency_hist_t* hist, uint32_t latency, uint32_t bus_us)
+{
+    // Halve the window so older samples fade out
+    if (hist->count >= SNESPAD_STATS_WINDOW) {
+        hist->count = 0;
+        for (uint8_t i = 0; i < SNESPAD_STATS_BUCKETS; i++) {
+            hist->buckets[i] >>= 1;
+            hist->count += hist->buckets[i];
+        }
+        hist->sum_us >>= 1;
+        hist->sum_bus_us >>= 1;
+    }
+
+    hist->buckets[snespad_latency_bucket(latency)]++;
+    hist->count++;
+    hist->sum_us += latency;
+    hist->sum_bus_us += bus_us;
+
+    if (latency < hist->min_us) hist->min_us = latency;
+    if (latency > hist->max_us) hist->max_us = latency;
+}
+
+bool snespad_latency_summary(const snespad_latency_hist_t* hist, snespad_latency_t* latency)
+{
+    uint32_t target, seen = 0;
+
+    latency->count = 0;
+    latency->min_us = 0;
+    latency->avg_us = 0;
+    latency->p99_us = 0;
+    latency->max_us = 0;
+    latency->avg_bus_us = 0;
+
+    if (!hist || !hist->count) {
+        return false;
+    }
+
+    latency->count = hist->count;
+    latency->min_us = hist->min_us;
+    latency->max_us = hist->max_us;
+    latency->avg_us = hist->sum_us / hist->count;
+    latency->avg_bus_us = hist->sum_bus_us / hist->count;
+
+    // Smallest bucket bound covering 99% of the window
+    target = hist->count - hist->count / 100;
+    for (uint8_t i = 0; i < SNESPAD_STATS_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= target) {
+            latency->p99_us = snespad_latency_bucket_max(i);
+            break;
+        }
+    }
+    if (latency->p99_us > latency->max_us) {
+        latency->p99_us = latency->max_us;
+    }
+
+    return true;
+}
+
+void snespad_latency_clear(snespad_latency_hist_t* hist)
+{
+    for (uint8_t i = 0; i < SNESPAD_STATS_BUCKETS; i++) {
+        hist->buckets[i] = 0;
+    }
+    hist->count = 0;
+    hist->sum_us = 0;
+    hist->sum_bus_us = 0;
+    hist->min_us = UINT32_MAX;
+    hist->max_us = 0;
+}
+
+void snespad_stats_publish(snespad_t* pad)
+{
+    snespad_stats_t* stats = &pad->stats;
+
+    if (!stats->pending || pad->type < SNESPAD_CONTROLLER || pad->type > SNESPAD_KEYBOARD) {
+        stats->pending = false;
+        return;
+    }
+    stats->pending = false;
+
+    STATS_TIME(pad, published_us);
+    snespad_latency_add(&stats->hist[pad->type],
+                        stats->last.published_us - stats->last.latch_us,
+                        stats->last.sampled_us - stats->last.latch_us);
+}
+
+bool snespad_get_latency(const snespad_t* pad, int8_t type, snespad_latency_t* latency)
+{
+    bool known = type >= SNESPAD_CONTROLLER && type <= SNESPAD_KEYBOARD;
+
+    return snespad_latency_summary(known ? &pad->stats.hist[type] : NULL, latency);
+}
+
+void snespad_reset_latency(snespad_t* pad)
+{
+    pad->stats.pending = false;
+    for (uint8_t t = 0; t < 4; t++) {
+        snespad_latency_clear(&pad->stats.hist[t]);
+    }
+}
+
+#endif // SNESPAD_STATS
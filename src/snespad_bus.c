@@ -0,0 +1,282 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Platform bus transports (Arduino and Pico SDK).
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_bus.h"
+
+#include <stddef.h>
+
+#if defined(ARDUINO)
+#include "Arduino.h"
+#if defined(ARDUINO_ARCH_RP2040)
+#include "hardware/gpio.h"
+#endif
+#elif !defined(SNESPAD_HOST)
+#include "pico/stdlib.h"
+#endif
+
+#if defined(ARDUINO)
+
+// ============================================================================
+// Arduino
+// ============================================================================
+
+static void platform_pin_mode(void* ctx, uint8_t pin, uint8_t mode)
+{
+    (void)ctx;
+
+    switch (mode) {
+        case SNESPAD_PIN_OUTPUT:
+            pinMode(pin, OUTPUT);
+            break;
+        case SNESPAD_PIN_INPUT_PULLUP:
+            pinMode(pin, INPUT);
+            digitalWrite(pin, HIGH);  // pull_up
+            break;
+        default:
+            pinMode(pin, INPUT);
+            break;
+    }
+}
+
+static void platform_write(void* ctx, uint8_t pin, uint8_t value)
+{
+    (void)ctx;
+    digitalWrite(pin, value ? HIGH : LOW);
+}
+
+static uint8_t platform_read(void* ctx, uint8_t pin)
+{
+    (void)ctx;
+    return digitalRead(pin);
+}
+
+static uint32_t platform_read_mask(void* ctx, uint32_t mask)
+{
+    uint32_t levels = 0;
+
+    (void)ctx;
+    for (uint8_t pin = 0; mask; pin++, mask >>= 1) {
+        if ((mask & 1) && digitalRead(pin)) {
+            levels |= (uint32_t)1 << pin;
+        }
+    }
+
+    return levels;
+}
+
+static void platform_delay_us(void* ctx, uint32_t us)
+{
+    (void)ctx;
+    delayMicroseconds(us);
+}
+
+static uint32_t platform_now_us(void* ctx)
+{
+    (void)ctx;
+    return micros();
+}
+
+// attachInterrupt() handlers take no argument, so each edge slot gets its
+// own trampoline (device mode needs two: latch and clock; sniffer mode
+// all five lines)
+#define EDGE_SLOTS  5
+
+// Level read inside the interrupt: one input register read where the
+// core allows it, digitalRead() (table lookups and timer checks) otherwise
+#if defined(ARDUINO_ARCH_RP2040)
+#define edge_level(pin)  gpio_get(pin)
+#elif defined(portInputRegister) && defined(digitalPinToPort)
+#define edge_level(pin)  ((*portInputRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin)) != 0)
+#else
+#define edge_level(pin)  digitalRead(pin)
+#endif
+
+static struct {
+    uint8_t pin;
+    snespad_edge_fn handler;
+    void* arg;
+} edge_slot[EDGE_SLOTS];
+
+static void edge_dispatch(uint8_t slot)
+{
+    uint8_t pin = edge_slot[slot].pin;
+
+    edge_slot[slot].handler(edge_slot[slot].arg, pin, edge_level(pin));
+}
+
+static void edge_isr0(void) { edge_dispatch(0); }
+static void edge_isr1(void) { edge_dispatch(1); }
+static void edge_isr2(void) { edge_dispatch(2); }
+static void edge_isr3(void) { edge_dispatch(3); }
+static void edge_isr4(void) { edge_dispatch(4); }
+
+static bool platform_attach_edge(void* ctx, uint8_t pin, snespad_edge_fn handler, void* arg)
+{
+    static void (*const isr[EDGE_SLOTS])(void) = { edge_isr0, edge_isr1, edge_isr2, edge_isr3, edge_isr4 };
+    int irq = digitalPinToInterrupt(pin);
+    uint8_t slot;
+
+    (void)ctx;
+    if (irq < 0) {
+        return false;
+    }
+
+    for (slot = 0; slot < EDGE_SLOTS; slot++) {
+        if (edge_slot[slot].handler && edge_slot[slot].pin == pin) break;
+    }
+    if (!handler) {
+        if (slot < EDGE_SLOTS) {
+            detachInterrupt(irq);
+            edge_slot[slot].handler = NULL;
+        }
+        return true;
+    }
+    if (slot == EDGE_SLOTS) {
+        for (slot = 0; slot < EDGE_SLOTS && edge_slot[slot].handler; slot++) {
+        }
+        if (slot == EDGE_SLOTS) {
+            return false;
+        }
+    }
+
+    edge_slot[slot].pin = pin;
+    edge_slot[slot].arg = arg;
+    edge_slot[slot].handler = handler;
+    attachInterrupt(irq, isr[slot], CHANGE);
+    return true;
+}
+
+#elif !defined(SNESPAD_HOST)
+
+// ============================================================================
+// Pico SDK
+// ============================================================================
+
+static void platform_pin_mode(void* ctx, uint8_t pin, uint8_t mode)
+{
+    (void)ctx;
+
+    gpio_init(pin);
+    if (mode == SNESPAD_PIN_OUTPUT) {
+        gpio_set_dir(pin, GPIO_OUT);
+    } else {
+        gpio_set_dir(pin, GPIO_IN);
+        if (mode == SNESPAD_PIN_INPUT_PULLUP) {
+            gpio_pull_up(pin);
+        }
+    }
+}
+
+static void platform_write(void* ctx, uint8_t pin, uint8_t value)
+{
+    (void)ctx;
+    gpio_put(pin, value ? 1 : 0);
+}
+
+static uint8_t platform_read(void* ctx, uint8_t pin)
+{
+    (void)ctx;
+    return gpio_get(pin);
+}
+
+static uint32_t platform_read_mask(void* ctx, uint32_t mask)
+{
+    (void)ctx;
+    return gpio_get_all() & mask;  // single GPIO bank read
+}
+
+static void platform_delay_us(void* ctx, uint32_t us)
+{
+    (void)ctx;
+    busy_wait_us(us);
+}
+
+static uint32_t platform_now_us(void* ctx)
+{
+    (void)ctx;
+    return time_us_32();
+}
+
+// One shared GPIO interrupt callback per core; dispatch by pin
+static snespad_edge_fn edge_handler[NUM_BANK0_GPIOS];
+static void* edge_arg[NUM_BANK0_GPIOS];
+
+static void platform_gpio_irq(uint gpio, uint32_t events)
+{
+    uint8_t level;
+
+    if (gpio >= NUM_BANK0_GPIOS || !edge_handler[gpio]) return;
+
+    if ((events & GPIO_IRQ_EDGE_RISE) && (events & GPIO_IRQ_EDGE_FALL)) {
+        level = gpio_get(gpio);  // both seen, report where it ended up
+    } else {
+        level = (events & GPIO_IRQ_EDGE_RISE) != 0;
+    }
+    edge_handler[gpio](edge_arg[gpio], gpio, level);
+}
+
+static bool platform_attach_edge(void* ctx, uint8_t pin, snespad_edge_fn handler, void* arg)
+{
+    (void)ctx;
+    if (pin >= NUM_BANK0_GPIOS) {
+        return false;
+    }
+
+    if (!handler) {
+        gpio_set_irq_enabled(pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, false);
+        edge_handler[pin] = NULL;
+        return true;
+    }
+
+    edge_arg[pin] = arg;
+    edge_handler[pin] = handler;
+    gpio_set_irq_enabled_with_callback(pin, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true, platform_gpio_irq);
+    return true;
+}
+
+#endif
+
+#if defined(SNESPAD_HOST)
+
+const snespad_bus_t* snespad_bus_platform(void)
+{
+    return NULL;
+}
+
+#else
+
+static const snespad_bus_t platform_bus = {
+    platform_pin_mode,
+    platform_write,
+    platform_read,
+    platform_read_mask,
+    platform_delay_us,
+    platform_now_us,
+    platform_attach_edge,
+    NULL
+};
+
+const snespad_bus_t* snespad_bus_platform(void)
+{
+    return &platform_bus;
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Bus transport interface. Every pin access, delay and timestamp made by
+  the library goes through a snespad_bus_t so the same protocol code can
+  run against real GPIO (Arduino / Pico SDK) or a simulated bus on a host.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_BUS_H
+#define SNESPAD_BUS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pin modes for snespad_bus_t.pin_mode
+#define SNESPAD_PIN_OUTPUT        0
+#define SNESPAD_PIN_INPUT         1
+#define SNESPAD_PIN_INPUT_PULLUP  2
+
+// Edge handler: called from interrupt context with the pin's new level
+typedef void (*snespad_edge_fn)(void* arg, uint8_t pin, uint8_t level);
+
+// Bus transport
+// All callbacks receive the ctx pointer stored alongside them.
+typedef struct snespad_bus {
+    // Configure a pin (SNESPAD_PIN_*)
+    void (*pin_mode)(void* ctx, uint8_t pin, uint8_t mode);
+
+    // Drive an output pin high (non-zero) or low (0)
+    void (*write)(void* ctx, uint8_t pin, uint8_t value);
+
+    // Read a single input pin (returns 0 or 1)
+    uint8_t (*read)(void* ctx, uint8_t pin);
+
+    // Read several pins at once. Bit n of mask selects pin n (pins 0-31),
+    // bit n of the result holds that pin's level.
+    uint32_t (*read_mask)(void* ctx, uint32_t mask);
+
+    // Busy-wait for the given number of microseconds
+    void (*delay_us)(void* ctx, uint32_t us);
+
+    // Monotonic microsecond clock (wraps at 2^32)
+    uint32_t (*now_us)(void* ctx);
+
+    // Call handler(arg, pin, level) on every edge of an input pin (NULL
+    // handler detaches). Returns false if the pin cannot interrupt.
+    // Only needed for device mode; may be NULL.
+    bool (*attach_edge)(void* ctx, uint8_t pin, snespad_edge_fn handler, void* arg);
+
+    void* ctx;
+} snespad_bus_t;
+
+// Transport for the platform the library was compiled for
+// (Arduino or Pico SDK). Returns NULL on host builds (SNESPAD_HOST),
+// where a bus must be supplied with snespad_set_bus().
+const snespad_bus_t* snespad_bus_platform(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_BUS_H
@@ -31,6 +31,14 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "snespad_bus.h"
+#include "snespad_events.h"
+#include "snespad_snapshot.h"
+#include "snespad_keyboard.h"
+#include "snespad_motion.h"
+#include "snespad_log.h"
+#include "snespad_trace.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -40,6 +48,16 @@ extern "C" {
 #define SNES_PAD_DEBUG 0
 #endif
 
+// Latency statistics (set to 1 to record poll timestamps and histograms)
+#ifndef SNESPAD_STATS
+#define SNESPAD_STATS 0
+#endif
+
+// Bus trace (set to 1 to let pads record driven edges and samples, see snespad_trace.h)
+#ifndef SNESPAD_TRACE
+#define SNESPAD_TRACE 0
+#endif
+
 // Device types
 #define SNESPAD_NONE       -1
 #define SNESPAD_CONTROLLER  0
@@ -66,6 +84,10 @@ extern "C" {
 #define SNES_L              0x0400
 #define SNES_R              0x0800
 #define SNES_DEVICE_ID      0xF000
+#define SNES_BUTTONS        0x0FFF  // all button bits
+
+// snespad_t.buttons uses the masks above for every device: NES A/B are
+// reported as SNES_A/SNES_B, mouse left/right as SNES_B/SNES_A.
 
 // Mouse-specific masks
 #define SNES_MOUSE_SPEED    0x0C00
@@ -79,12 +101,13 @@ extern "C" {
 #define SNES_MOUSE_MEDIUM   2
 #define SNES_MOUSE_FAST     1
 
-#define SNES_MOUSE_THRESHOLD 10   // max speed fails (Hyperkin compatibility)
+#define SNES_MOUSE_THRESHOLD 10   // speed fails before cycling is given up (Hyperkin compatibility)
 #define SNES_MOUSE_PRECISION 1    // mouse movement velocity multiplier
 
 // Keyboard scancodes
 #define SNES_KEY_RELEASE    0xF0  // scancode: next key released
 #define SNES_KEY_SPECIAL    0xE0  // scancode: next key special
+#define SNES_KEY_CAPS       0x58  // scancode: Caps Lock
 
 // Special key scancodes (after SNES_KEY_SPECIAL)
 #define SNES_KEY_RETURN     0x5A
@@ -124,6 +147,82 @@ extern "C" {
 #define KEY_RIGHT_ARROW     0xD7
 #endif
 
+// Default bus half-period (microseconds)
+#define SNES_TIMING_DEFAULT_US  12
+
+// Bus timing profile (microseconds)
+typedef struct {
+    uint8_t latch_us;       // Latch high width (and hold after latch falls)
+    uint8_t clock_low_us;   // Clock low half-period
+    uint8_t clock_high_us;  // Clock high half-period
+    uint8_t sample_us;      // Clock falling edge to data sample (<= clock_low_us)
+} snespad_timing_t;
+
+// Auto-calibration settings (see snespad_calibrate)
+typedef struct {
+    uint8_t min_us;         // Fastest half-period to try
+    uint8_t step_us;        // Half-period decrement between candidates
+    uint8_t reads;          // Verified reads required per candidate
+    uint8_t margin_pct;     // Margin added on top of the fastest passing rate
+} snespad_calibration_t;
+
+// In-progress bus transfer (driven by snespad_poll_step / snespad_poll)
+typedef struct {
+    uint8_t phase;          // Current bus phase (0 = idle)
+    uint8_t mode;           // What the completed packet is used for
+    uint8_t stage;          // Keyboard transaction stage
+    uint8_t index;          // Bit index within the current field
+    uint8_t kid;            // Keyboard id
+    uint8_t num;            // Keyboard scancode count
+    uint8_t n;              // Scancodes read so far
+    uint8_t byte;           // Scancode being assembled
+    bool disconnected;      // Data line idle high before latch
+    bool readonly_id;       // Keyboard id only (no scancodes)
+    uint32_t dat;           // Packet being assembled (result once complete)
+    uint32_t wait_us;       // Hold time requested by the last phase
+    uint32_t deadline_us;   // Bus time at which the next phase may run
+    uint32_t latch_us;      // Bus time of the latch (events only)
+} snespad_xfer_t;
+
+#if SNESPAD_STATS
+#define SNESPAD_STATS_BUCKETS  64     // 4 per octave, up to 131 ms
+#define SNESPAD_STATS_WINDOW   4096   // polls before the histogram is halved
+
+// Bus clock timestamps of one poll
+typedef struct {
+    uint32_t latch_us;          // Latch asserted
+    uint32_t sampled_us;        // Last data bit sampled
+    uint32_t decoded_us;        // Packet decoded into the pad state
+    uint32_t published_us;      // snespad_poll / snespad_poll_step returned it
+} snespad_poll_times_t;
+
+// Latency histogram for one device type
+typedef struct {
+    uint16_t buckets[SNESPAD_STATS_BUCKETS];
+    uint16_t count;             // Polls in the window
+    uint32_t sum_us;            // Latch to publish, over the window
+    uint32_t sum_bus_us;        // Latch to last sample, over the window
+    uint32_t min_us;            // Since reset
+    uint32_t max_us;            // Since reset
+} snespad_latency_hist_t;
+
+typedef struct {
+    snespad_poll_times_t last;  // Most recent poll
+    bool pending;               // last holds a decode not yet published
+    snespad_latency_hist_t hist[4];  // Indexed by device type
+} snespad_stats_t;
+
+// Latency summary (latch to publish) for one device type
+typedef struct {
+    uint32_t count;             // Polls in the rolling window
+    uint32_t min_us;            // Since reset
+    uint32_t avg_us;            // Rolling window
+    uint32_t p99_us;            // Rolling window (bucket upper bound)
+    uint32_t max_us;            // Since reset
+    uint32_t avg_bus_us;        // Rolling window, latch to last sample
+} snespad_latency_t;
+#endif
+
 // Xband keyboard key mapping
 typedef struct {
     const char* key_string;     // String representation of the key
@@ -131,6 +230,13 @@ typedef struct {
     bool releasable;            // Keys that get a released scancode
 } snespad_key_mapping_t;
 
+// One packet decoded the same way for every device type
+typedef struct {
+    uint16_t buttons;           // SNES_* masks (NES and mouse buttons remapped)
+    int8_t dx;                  // Mouse counts, -127..127 (0 for other devices)
+    int8_t dy;
+} snespad_input_t;
+
 // SNESpad state structure
 typedef struct {
     // Device type (-1 = none, 0 = controller, 1 = NES, 2 = mouse, 3 = keyboard)
@@ -143,7 +249,15 @@ typedef struct {
     uint8_t data1_pin;
     uint8_t iobit_pin;
 
-    // Controller/NES button state
+    // Bus transport (platform GPIO unless replaced with snespad_set_bus)
+    const snespad_bus_t* bus;
+
+    // Button state (SNES_* masks)
+    uint16_t buttons;           // Buttons held
+    uint16_t pressed;           // Buttons that went down during the last poll
+    uint16_t released;          // Buttons that went up during the last poll
+
+    // Button state as fields (compatibility view of buttons)
     bool button_a;
     bool button_b;
     bool button_x;
@@ -161,12 +275,16 @@ typedef struct {
     uint16_t mouse_x;
     uint16_t mouse_y;
     uint8_t mouse_speed;
-    uint8_t mouse_speed_fails;
+    uint8_t mouse_speed_target;     // Requested speed (snespad_set_mouse_speed)
+    uint8_t mouse_speed_pulses;     // Speed pulses sent with the last latch
+    uint8_t mouse_speed_fails;      // Pulsed latches in a row without a speed change
+    bool mouse_speed_unsupported;   // Mouse ignores speed pulses (Hyperkin), reset on unplug
 
     // Keyboard state
     uint8_t scancodes[16];
     uint8_t scancodes_len;
     bool caps_locked;
+    snespad_keyboard_t key_decoder;  // Decodes scancodes while no keyboard is set
 
     // Rumble output (LRG protocol via IOBit)
     uint16_t rumble_frame;      // 16-bit frame to shift out (0x72XX)
@@ -175,6 +293,39 @@ typedef struct {
     uint8_t  rumble_left;       // Current left motor intensity (0-15)
     uint8_t  rumble_right;      // Current right motor intensity (0-15)
 
+    // Bus timing per device type (indexed by type + 1, SNESPAD_NONE = detect)
+    snespad_timing_t timing[5];
+
+    // Bus transfer state machine
+    snespad_xfer_t xfer;
+
+    // Input events (NULL = off)
+    snespad_event_queue_t* events;
+    uint8_t event_port;
+
+    // Published state for other cores/threads (NULL = off)
+    snespad_snapshot_slot_t* snapshot;
+
+    // Keyboard decoder (NULL = off)
+    snespad_keyboard_t* keyboard;
+
+    // Mouse motion accumulator (NULL = off)
+    snespad_motion_t* motion;
+
+    // Packet log: record completed transfers / take them from a log (NULL = off)
+    snespad_log_t* record;
+    snespad_log_t* replay;
+
+#if SNESPAD_STATS
+    // Poll latency (SNESPAD_STATS builds)
+    snespad_stats_t stats;
+#endif
+
+#if SNESPAD_TRACE
+    // Bus trace (SNESPAD_TRACE builds, NULL = off)
+    snespad_trace_t* trace;
+#endif
+
     // Debug/internal
     uint32_t last_read;
 } snespad_t;
@@ -194,6 +345,13 @@ typedef struct {
 void snespad_init(snespad_t* pad, uint8_t clock, uint8_t latch,
                   uint8_t data0, uint8_t data1, uint8_t iobit);
 
+// Replace the bus transport used for all pin access and timing
+// Call this after snespad_init() and before snespad_begin()
+// Parameters:
+//   pad - Pointer to snespad_t structure
+//   bus - Transport to use (must outlive the pad)
+void snespad_set_bus(snespad_t* pad, const snespad_bus_t* bus);
+
 // Initialize GPIO pins for communication
 // Call this after snespad_init() to set up the hardware
 void snespad_begin(snespad_t* pad);
@@ -208,6 +366,117 @@ void snespad_start(snespad_t* pad);
 // If device disconnects, will automatically call snespad_start()
 void snespad_poll(snespad_t* pad);
 
+// Advance a non-blocking poll by one bus phase
+// Call repeatedly from the main loop or a timer callback. Each call that
+// finds the current phase's hold time elapsed performs the next latch or
+// clock edge and returns; the packet is decoded (as in snespad_poll) on
+// the call that completes it. Edge timing is only as precise as the bus
+// clock (micros() on AVR has 4us resolution), so keep margin in the
+// device's timing profile.
+// Returns: true when a packet completed and the state was updated
+bool snespad_poll_step(snespad_t* pad);
+
+// true while a poll started by snespad_poll_step() is in progress
+bool snespad_poll_busy(const snespad_t* pad);
+
+// Bus clock time (now_us) at which the next snespad_poll_step() can
+// make progress, for arming a one-shot timer
+uint32_t snespad_poll_deadline(const snespad_t* pad);
+
+// Send input events for this pad to a queue
+// Polls push button, mouse, key and attach/detach events stamped with the
+// bus clock time of their latch. The queue has a single producer, so pads
+// sharing one must be polled from the same context.
+// Parameters:
+//   pad   - Pointer to snespad_t structure
+//   queue - Initialized queue (NULL to stop sending events)
+//   port  - Value stored in each event's port field
+void snespad_set_event_queue(snespad_t* pad, snespad_event_queue_t* queue, uint8_t port);
+
+// Publish the state to a snapshot slot after every poll
+// Readers on another core, thread or ISR use snespad_snapshot_read()
+// instead of reading snespad_t fields while a poll may be updating them.
+// Parameters:
+//   pad  - Pointer to snespad_t structure
+//   slot - Initialized slot (NULL to stop publishing)
+void snespad_set_snapshot(snespad_t* pad, snespad_snapshot_slot_t* slot);
+
+// Decode keyboard scancodes into held keys after every keyboard poll
+// The decoder's changes and held set are updated each poll, key events
+// (if a queue is set) come from it, held keys are released when the
+// keyboard is unplugged, and with caps_led set the Caps Lock LED follows
+// the decoded lock state. Without one the pad decodes with a built-in
+// decoder (caps_led off), so key events are the same either way.
+// Parameters:
+//   pad      - Pointer to snespad_t structure
+//   keyboard - Initialized decoder (NULL for the built-in one)
+void snespad_set_keyboard(snespad_t* pad, snespad_keyboard_t* keyboard);
+
+// Select the SNES mouse speed (SNES_MOUSE_SLOW, SNES_MOUSE_MEDIUM or
+// SNES_MOUSE_FAST; FAST by default)
+// The speed only cycles slow -> medium -> fast -> slow, one step per clock
+// pulse during latch. The next mouse poll sends the one or two pulses
+// needed and later polls leave the clock alone while the speed matches.
+// A mouse whose speed never follows (Hyperkin) is marked
+// mouse_speed_unsupported after SNES_MOUSE_THRESHOLD tries and no longer
+// pulsed until it is unplugged.
+// Parameters:
+//   pad   - Pointer to snespad_t structure
+//   speed - Requested speed
+void snespad_set_mouse_speed(snespad_t* pad, uint8_t speed);
+
+// Add every mouse poll's motion to an accumulator
+// mouse_x/mouse_y only hold the last poll's motion; the accumulator keeps
+// the signed counts of all polls until snespad_motion_take() drains them.
+// Parameters:
+//   pad    - Pointer to snespad_t structure
+//   motion - Initialized accumulator (NULL to stop accumulating)
+void snespad_set_motion(snespad_t* pad, snespad_motion_t* motion);
+
+// Record every completed transfer into a log
+// Call snespad_log_flush() before using the recorded bytes.
+// Parameters:
+//   pad - Pointer to snespad_t structure
+//   log - Log set up with snespad_log_init() or snespad_log_init_stream()
+//         (NULL to stop recording)
+void snespad_set_record(snespad_t* pad, snespad_log_t* log);
+
+// Take transfers from a recorded log instead of the bus
+// snespad_start()/snespad_poll() then decode the recorded packets in order
+// without touching the pins; once the log is used up the port reads as
+// unplugged.
+// Parameters:
+//   pad - Pointer to snespad_t structure
+//   log - Log opened with snespad_log_open() (NULL to read the bus again)
+void snespad_set_replay(snespad_t* pad, snespad_log_t* log);
+
+// Decode a packet with lookup tables, without branching on the device type
+// Parameters:
+//   type   - Device type (keyboard and SNESPAD_NONE decode to nothing)
+//   packet - Packet bits after inversion (as in last_read)
+//   input  - Receives the buttons and mouse counts
+void snespad_decode_packet(int8_t type, uint32_t packet, snespad_input_t* input);
+
+// HID keycode for a keyboard scancode (shared flash table, no RAM)
+// Parameters:
+//   scancode - The scancode read from keyboard
+//   special  - true if preceded by SNES_KEY_SPECIAL (0xE0)
+// Returns: Arduino Keyboard.h style keycode, 0 if the key has none
+uint8_t snespad_key_hid(uint8_t scancode, bool special);
+
+// USB HID usage ID (keyboard page) for a keyboard scancode
+// Returns: usage ID, 0xE0-0xE7 for modifiers, 0 if the key has none
+uint8_t snespad_key_usage(uint8_t scancode, bool special);
+
+// true if the key sends SNES_KEY_RELEASE + scancode when let go
+// (modifiers, Caps Lock and the special keys; others only send presses)
+bool snespad_key_releasable(uint8_t scancode, bool special);
+
+// Printable key name ("unused" if unassigned)
+// Defined in snespad_keynames.c; the names are only linked if this or
+// snespad_get_key_from_scancode() is called.
+const char* snespad_key_name(uint8_t scancode, bool special);
+
 // Get key mapping from keyboard scancode
 // Parameters:
 //   scancode - The scancode read from keyboard
@@ -230,6 +499,77 @@ void snespad_set_caps_lock_led(snespad_t* pad, bool enabled);
 //   right - Right motor intensity (0-255, scaled to 0-15)
 void snespad_set_rumble(snespad_t* pad, uint8_t left, uint8_t right);
 
+// Set the bus timing profile used while a device type is connected
+// Parameters:
+//   pad    - Pointer to snespad_t structure
+//   type   - Device type (SNESPAD_NONE sets the detection profile)
+//   timing - Latch width, clock low/high times and sample point
+void snespad_set_timing(snespad_t* pad, int8_t type, const snespad_timing_t* timing);
+
+// Get the bus timing profile for a device type
+void snespad_get_timing(const snespad_t* pad, int8_t type, snespad_timing_t* timing);
+
+// Auto-calibrate the bus timing for the connected device
+// Steps the half-period down from the current profile while reads at the
+// candidate rate still match reads taken at the current rate, then stores
+// the fastest passing rate plus margin as the device type's profile.
+// Keep buttons still while calibrating; keyboard scancodes and mouse
+// motion read during calibration are discarded.
+// Parameters:
+//   pad - Pointer to snespad_t structure
+//   cfg - Calibration settings (NULL = 1us floor, 1us steps, 8 reads, 25% margin)
+// Returns: true if a device was connected and its profile was updated
+bool snespad_calibrate(snespad_t* pad, const snespad_calibration_t* cfg);
+
+#if SNESPAD_STATS
+// Latency from latch to published state for a device type
+// Parameters:
+//   pad     - Pointer to snespad_t structure
+//   type    - Device type (SNESPAD_CONTROLLER .. SNESPAD_KEYBOARD)
+//   latency - Filled with min/avg/p99/max (all 0 if nothing was recorded)
+// Returns: false if type has no recorded polls
+bool snespad_get_latency(const snespad_t* pad, int8_t type, snespad_latency_t* latency);
+
+// Clear all latency histograms
+void snespad_reset_latency(snespad_t* pad);
+#endif
+
+#if SNESPAD_TRACE
+// Record the edges driven and the samples taken by every transfer
+// Parameters:
+//   pad   - Pointer to snespad_t structure
+//   trace - Trace set up with snespad_trace_init() (NULL to stop recording)
+void snespad_set_trace(snespad_t* pad, snespad_trace_t* trace);
+#endif
+
+// ============================================================================
+// Button State Accessors
+// ============================================================================
+
+// Buttons held (SNES_* masks)
+static inline uint16_t snespad_buttons(const snespad_t* pad)
+{
+    return pad->buttons;
+}
+
+// true if any button in mask is held
+static inline bool snespad_button_held(const snespad_t* pad, uint16_t mask)
+{
+    return (pad->buttons & mask) != 0;
+}
+
+// Buttons that went down during the last poll
+static inline uint16_t snespad_pressed(const snespad_t* pad)
+{
+    return pad->pressed;
+}
+
+// Buttons that went up during the last poll
+static inline uint16_t snespad_released(const snespad_t* pad)
+{
+    return pad->released;
+}
+
 #ifdef __cplusplus
 }
 #endif
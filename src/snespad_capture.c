@@ -0,0 +1,674 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Offline analysis of logic analyzer captures (host builds).
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if defined(SNESPAD_HOST)
+
+#include "snespad_capture.h"
+
+#include <string.h>
+
+// Parser states
+#define PARSE_HEADER     0  // VCD declarations
+#define PARSE_SKIP       1  // VCD: anything up to $end, then back to field
+#define PARSE_TIMESCALE  2  // VCD $timescale
+#define PARSE_VAR        3  // VCD $var
+#define PARSE_BODY       4  // VCD value changes
+#define PARSE_VECTOR_ID  5  // VCD: identifier of a vector change
+#define PARSE_CSV_HEAD   6  // CSV: comments and the header row
+#define PARSE_CSV_ROWS   7  // CSV samples
+
+#define VECTOR_NONE      0xFF
+
+#define NO_LINE          0xFF
+
+// Bus levels of lines the capture does not have
+#define LINES_IDLE  (SNESPAD_LINE_CLOCK | SNESPAD_LINE_DATA0 | SNESPAD_LINE_DATA1 | SNESPAD_LINE_IOBIT)
+
+#define DEFAULT_SAMPLERATE  1000000
+
+#define NS_PER_S  1000000000ULL
+
+// Usual signal names per line, matched without case
+static const char* const capture_aliases[5][4] = {
+    { "latch", "lat", "strobe", NULL },
+    { "clock", "clk", NULL },
+    { "data0", "data", "dat0", NULL },
+    { "data1", "dat1", NULL },
+    { "iobit", "io", NULL },
+};
+
+// Equal to a terminated string, ignoring case
+static bool capture_equal(const char* s, size_t n, const char* name)
+{
+    for (size_t i = 0; i < n; i++) {
+        char a = s[i], b = name[i];
+
+        if (a >= 'A' && a <= 'Z') a += 'a' - 'A';
+        if (b >= 'A' && b <= 'Z') b += 'a' - 'A';
+        if (a != b) {
+            return false;
+        }
+    }
+    return name[n] == '\0';
+}
+
+// Line index a signal name stands for
+static uint8_t capture_line(const snespad_capture_t* cap, const char* s, size_t n)
+{
+    for (uint8_t i = 0; i < 5; i++) {
+        if (cap->names[i][0]) {
+            if (capture_equal(s, n, cap->names[i])) {
+                return i;
+            }
+            continue;
+        }
+        for (uint8_t j = 0; capture_aliases[i][j]; j++) {
+            if (capture_equal(s, n, capture_aliases[i][j])) {
+                return i;
+            }
+        }
+    }
+    return NO_LINE;
+}
+
+// Decimal number scaled by 10^9 (seconds to ns, "24" to 24000000000);
+// takes a fraction and an exponent
+static uint64_t capture_decimal(const char* s, const char* end)
+{
+    uint64_t mant = 0;
+    int exp = 9;
+    bool frac = false;
+
+    for (; s < end; s++) {
+        if (*s >= '0' && *s <= '9') {
+            if (mant < 100000000000000000ULL) {
+                mant = mant * 10 + (*s - '0');
+                if (frac) exp--;
+            } else if (!frac) {
+                exp++;
+            }
+        } else if (*s == '.') {
+            frac = true;
+        } else if (*s == 'e' || *s == 'E') {
+            bool neg = false;
+            int e = 0;
+
+            if (++s < end && (*s == '-' || *s == '+')) {
+                neg = *s++ == '-';
+            }
+            for (; s < end && *s >= '0' && *s <= '9'; s++) {
+                e = e * 10 + (*s - '0');
+            }
+            exp += neg ? -e : e;
+            break;
+        } else if (*s != ' ' && *s != '"') {
+            break;
+        }
+    }
+
+    for (; exp > 0; exp--) mant *= 10;
+    for (; exp < 0 && mant; exp++) mant /= 10;
+    return mant;
+}
+
+static void capture_issue(snespad_capture_t* cap, uint64_t time_ns, uint8_t kind, uint8_t line,
+                          uint64_t width_ns, uint32_t limit_ns)
+{
+    snespad_capture_issue_t issue;
+
+    cap->issues[kind]++;
+    if (!cap->on_issue) {
+        return;
+    }
+    issue.time_ns = time_ns;
+    issue.kind = kind;
+    issue.line = line;
+    issue.width_ns = (uint32_t)width_ns;
+    issue.limit_ns = limit_ns;
+    cap->on_issue(cap->ctx, &issue);
+}
+
+// Phase of line i that began at its last change, checked against a limit
+static void capture_width(snespad_capture_t* cap, uint64_t t, uint8_t i, uint8_t kind, uint32_t limit)
+{
+    if ((cap->seen & (1 << i)) && t - cap->changed_ns[i] < limit) {
+        capture_issue(cap, t, kind, 1 << i, t - cap->changed_ns[i], limit);
+    }
+}
+
+static void capture_frame(snespad_capture_t* cap, const snespad_frame_t* frame)
+{
+    cap->frames++;
+    if (frame->resync) {
+        capture_issue(cap, cap->latch_ns, SNESPAD_ISSUE_RESYNC,
+                      SNESPAD_LINE_DATA0 | SNESPAD_LINE_DATA1, 0, 0);
+    }
+    if (cap->on_frame) {
+        cap->on_frame(cap->ctx, cap->latch_ns, frame);
+    }
+}
+
+// New line levels at time t
+static void capture_apply(snespad_capture_t* cap, uint64_t t, uint8_t lines)
+{
+    uint8_t prev = cap->lines;
+    uint8_t changed = lines ^ prev;
+    uint8_t rose = changed & lines;
+    snespad_frame_t frame;
+
+    cap->now_ns = t;
+
+    // The first sample is where the lines stand, not an edge
+    if (!cap->started) {
+        cap->started = true;
+        cap->lines = lines;
+        cap->framer.lines = lines;
+        return;
+    }
+    if (!changed) {
+        return;
+    }
+    cap->edges++;
+
+    if (changed & SNESPAD_LINE_LATCH && !rose) {
+        capture_width(cap, t, 0, SNESPAD_ISSUE_SHORT_LATCH, cap->limits.latch_ns);
+    }
+    if (changed & SNESPAD_LINE_CLOCK) {
+        if (!(rose & SNESPAD_LINE_CLOCK)) {
+            capture_width(cap, t, 1, SNESPAD_ISSUE_SHORT_CLOCK_HIGH, cap->limits.clock_high_ns);
+        } else {
+            capture_width(cap, t, 1, SNESPAD_ISSUE_SHORT_CLOCK_LOW, cap->limits.clock_low_ns);
+
+            // Data changing at this very edge is the device shifting after it
+            if (!(prev & SNESPAD_LINE_LATCH)) {
+                capture_width(cap, t, 2, SNESPAD_ISSUE_LATE_SAMPLE, cap->limits.setup_ns);
+                if (!(prev & SNESPAD_LINE_IOBIT)) {
+                    capture_width(cap, t, 3, SNESPAD_ISSUE_LATE_SAMPLE, cap->limits.setup_ns);
+                }
+            }
+        }
+    }
+
+    for (uint8_t i = 0; i < 5; i++) {
+        if (changed & (1 << i)) {
+            cap->changed_ns[i] = t;
+        }
+    }
+    cap->seen |= changed;
+    cap->lines = lines;
+
+    if (snespad_framer_edge(&cap->framer, (uint32_t)(t / 1000), lines, &frame)) {
+        capture_frame(cap, &frame);
+    }
+    if (rose & SNESPAD_LINE_LATCH) {
+        cap->latch_ns = t;
+    }
+}
+
+// ============================================================================
+// VCD
+// ============================================================================
+
+static uint64_t vcd_ns(const snespad_capture_t* cap)
+{
+    return cap->time * cap->scale_mul / cap->scale_div;
+}
+
+// $timescale: "1ns", or "1" and "ns" as two tokens
+static void vcd_timescale(snespad_capture_t* cap, const char* s, size_t n)
+{
+    size_t i = 0;
+
+    if (s[0] >= '0' && s[0] <= '9') {
+        cap->time = 0;
+        for (; i < n && s[i] >= '0' && s[i] <= '9'; i++) {
+            cap->time = cap->time * 10 + (s[i] - '0');
+        }
+    }
+    if (i == n) {
+        return;
+    }
+
+    cap->scale_mul = cap->time ? cap->time : 1;
+    cap->scale_div = 1;
+    switch (s[i]) {
+        case 's':  cap->scale_mul *= NS_PER_S;  break;
+        case 'm':  cap->scale_mul *= 1000000;   break;
+        case 'u':  cap->scale_mul *= 1000;      break;
+        case 'p':  cap->scale_div = 1000;       break;
+        case 'f':  cap->scale_div = 1000000;    break;
+        default:   break;
+    }
+    cap->time = 0;
+}
+
+// Value change of a scalar (or one-bit vector) with identifier s
+static void vcd_change(snespad_capture_t* cap, const char* s, size_t n, uint8_t value)
+{
+    for (uint8_t i = 0; i < 5; i++) {
+        if (cap->id_len[i] == n && !memcmp(cap->ids[i], s, n)) {
+            cap->pending = value ? cap->pending | (1 << i) : cap->pending & ~(1 << i);
+            cap->dirty = true;
+        }
+    }
+}
+
+static void vcd_token(snespad_capture_t* cap, const char* s, size_t n)
+{
+    switch (cap->state) {
+        case PARSE_BODY:
+            switch (s[0]) {
+                case '#':
+                    // Changes at the previous time are complete
+                    if (cap->dirty) {
+                        cap->dirty = false;
+                        capture_apply(cap, vcd_ns(cap), cap->pending);
+                    }
+                    cap->time = 0;
+                    for (size_t i = 1; i < n && s[i] >= '0' && s[i] <= '9'; i++) {
+                        cap->time = cap->time * 10 + (s[i] - '0');
+                    }
+                    return;
+                case '0':
+                case '1':
+                    vcd_change(cap, s + 1, n - 1, s[0] - '0');
+                    return;
+                case 'x': case 'X': case 'z': case 'Z':
+                    return;  // unknown levels keep the last one
+                case 'b': case 'B':
+                    cap->vector = (n == 2 && (s[1] == '0' || s[1] == '1')) ? s[1] - '0' : VECTOR_NONE;
+                    cap->state = PARSE_VECTOR_ID;
+                    return;
+                case 'r': case 'R':
+                    cap->vector = VECTOR_NONE;
+                    cap->state = PARSE_VECTOR_ID;
+                    return;
+                case '$':
+                    if (capture_equal(s, n, "$comment")) {
+                        cap->field = PARSE_BODY;
+                        cap->state = PARSE_SKIP;
+                    }
+                    return;  // $dumpvars, $end, ...
+                default:
+                    cap->errors++;
+                    return;
+            }
+
+        case PARSE_VECTOR_ID:
+            if (cap->vector != VECTOR_NONE) {
+                vcd_change(cap, s, n, cap->vector);
+            }
+            cap->state = PARSE_BODY;
+            return;
+
+        case PARSE_HEADER:
+            if (capture_equal(s, n, "$timescale")) {
+                cap->time = 0;
+                cap->state = PARSE_TIMESCALE;
+            } else if (capture_equal(s, n, "$var")) {
+                cap->field = 0;
+                cap->state = PARSE_VAR;
+            } else if (capture_equal(s, n, "$enddefinitions")) {
+                cap->field = PARSE_BODY;
+                cap->state = PARSE_SKIP;
+            } else if (s[0] == '$' && !capture_equal(s, n, "$end")) {
+                cap->field = PARSE_HEADER;
+                cap->state = PARSE_SKIP;
+            }
+            return;
+
+        case PARSE_SKIP:
+            if (capture_equal(s, n, "$end")) {
+                cap->state = cap->field;
+            }
+            return;
+
+        case PARSE_TIMESCALE:
+            if (capture_equal(s, n, "$end")) {
+                cap->time = 0;
+                cap->state = PARSE_HEADER;
+            } else {
+                vcd_timescale(cap, s, n);
+            }
+            return;
+
+        default:  // PARSE_VAR: type, size, identifier, name [, range] $end
+            if (capture_equal(s, n, "$end")) {
+                cap->state = PARSE_HEADER;
+                return;
+            }
+            switch (cap->field++) {
+                case 1:
+                    cap->var_scalar = n == 1 && s[0] == '1';
+                    break;
+                case 2:
+                    cap->var_id_len = n <= sizeof(cap->var_id) ? (uint8_t)n : 0;
+                    memcpy(cap->var_id, s, cap->var_id_len);
+                    break;
+                case 3: {
+                    uint8_t line = capture_line(cap, s, n);
+
+                    // The first variable of a name wins
+                    if (line != NO_LINE && cap->var_scalar && cap->var_id_len &&
+                        !cap->id_len[line]) {
+                        memcpy(cap->ids[line], cap->var_id, cap->var_id_len);
+                        cap->id_len[line] = cap->var_id_len;
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+            return;
+    }
+}
+
+// ============================================================================
+// sigrok CSV
+// ============================================================================
+
+// "; Samplerate: 24 MHz"
+static void csv_comment(snespad_capture_t* cap, const char* s, size_t n)
+{
+    static const char key[] = "Samplerate:";
+    const char* end = s + n;
+    uint64_t value, mult = 1;
+
+    for (; s + sizeof(key) - 1 <= end; s++) {
+        if (!memcmp(s, key, sizeof(key) - 1)) {
+            break;
+        }
+    }
+    if (s + sizeof(key) - 1 > end || cap->samplerate) {
+        return;
+    }
+    s += sizeof(key) - 1;
+    value = capture_decimal(s, end);
+
+    for (; s < end; s++) {
+        if (*s == 'k') { mult = 1000; break; }
+        if (*s == 'M') { mult = 1000000; break; }
+        if (*s == 'G') { mult = 1000000000; break; }
+    }
+    cap->samplerate = mult >= 1000 ? value * (mult / 1000) / 1000000 : value / NS_PER_S;
+}
+
+// Header row: column names
+static void csv_header(snespad_capture_t* cap, const char* s, size_t n)
+{
+    const char* end = s + n;
+    uint8_t col = 0;
+
+    while (s <= end && col < SNESPAD_CAPTURE_COLUMNS) {
+        const char* f = s;
+        const char* e;
+
+        while (s < end && *s != ',') s++;
+        e = s++;
+        while (f < e && (*f == ' ' || *f == '"')) f++;
+        while (e > f && (e[-1] == ' ' || e[-1] == '"')) e--;
+
+        if (e - f >= 4 && capture_equal(f, 4, "time")) {
+            cap->time_column = col;
+        } else {
+            uint8_t line = capture_line(cap, f, e - f);
+
+            cap->columns[col] = line != NO_LINE ? (int8_t)line : -1;
+        }
+        col++;
+    }
+    cap->ncolumns = col;
+}
+
+static void csv_row(snespad_capture_t* cap, const char* s, size_t n)
+{
+    const char* end = s + n;
+    uint8_t lines = cap->pending;
+    uint64_t t = 0;
+    uint8_t col = 0;
+
+    while (s < end && col < cap->ncolumns) {
+        const char* f = s;
+
+        while (s < end && *s != ',') s++;
+        if (col == cap->time_column) {
+            t = capture_decimal(f, s);
+        } else if (cap->columns[col] >= 0) {
+            uint8_t bit = 1 << cap->columns[col];
+
+            while (f < s && (*f == ' ' || *f == '"')) f++;
+            lines = (f < s && *f == '1') ? lines | bit : lines & ~bit;
+        }
+        s++;
+        col++;
+    }
+
+    if (cap->time_column < 0) {
+        t = cap->row / cap->samplerate * NS_PER_S + cap->row % cap->samplerate * NS_PER_S / cap->samplerate;
+    }
+    cap->row++;
+    cap->pending = lines;
+    capture_apply(cap, t, lines);
+}
+
+static void csv_line(snespad_capture_t* cap, const char* s, size_t n)
+{
+    while (n && (s[n - 1] == '\r' || s[n - 1] == ' ')) n--;
+    if (!n) {
+        return;
+    }
+    if (s[0] == ';') {
+        csv_comment(cap, s, n);
+        return;
+    }
+
+    if (cap->state == PARSE_CSV_HEAD) {
+        bool header = false;
+
+        for (size_t i = 0; i < n; i++) {
+            char c = s[i];
+
+            if (((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) && c != 'e' && c != 'E') {
+                header = true;
+                break;
+            }
+        }
+        if (!cap->samplerate) {
+            cap->samplerate = DEFAULT_SAMPLERATE;
+        }
+        cap->state = PARSE_CSV_ROWS;
+        if (header) {
+            csv_header(cap, s, n);
+            return;
+        }
+        for (uint8_t i = 0; i < 5; i++) {
+            cap->columns[i] = (int8_t)i;
+        }
+        cap->ncolumns = 5;
+    }
+    csv_row(cap, s, n);
+}
+
+// One whitespace separated VCD token or one CSV line
+static void capture_unit(snespad_capture_t* cap, const char* s, size_t n)
+{
+    if (cap->format == SNESPAD_CAPTURE_CSV) {
+        csv_line(cap, s, n);
+    } else {
+        vcd_token(cap, s, n);
+    }
+}
+
+static inline bool vcd_space(char c)
+{
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+// End of the unit at s (end if it runs past the chunk)
+static const char* capture_scan(const snespad_capture_t* cap, const char* s, const char* end)
+{
+    if (cap->format == SNESPAD_CAPTURE_CSV) {
+        const char* nl = (const char*)memchr(s, '\n', end - s);
+        return nl ? nl : end;
+    }
+    while (s < end && !vcd_space(*s)) s++;
+    return s;
+}
+
+// ============================================================================
+// Public API Implementation
+// ============================================================================
+
+void snespad_capture_init(snespad_capture_t* cap, uint8_t format)
+{
+    memset(cap, 0, sizeof(*cap));
+    cap->format = format;
+
+    cap->limits.latch_ns = 2000;
+    cap->limits.clock_low_ns = 4000;
+    cap->limits.clock_high_ns = 4000;
+    cap->limits.setup_ns = 3000;
+
+    cap->state = format == SNESPAD_CAPTURE_CSV ? PARSE_CSV_HEAD : PARSE_HEADER;
+    cap->vector = VECTOR_NONE;
+    cap->scale_mul = 1;
+    cap->scale_div = 1;
+    for (uint8_t i = 0; i < SNESPAD_CAPTURE_COLUMNS; i++) {
+        cap->columns[i] = -1;
+    }
+    cap->time_column = -1;
+
+    cap->pending = LINES_IDLE;
+    cap->lines = LINES_IDLE;
+    snespad_framer_init(&cap->framer);
+}
+
+uint8_t snespad_capture_detect(const char* data, size_t len)
+{
+    size_t i = 0;
+
+    while (i < len && vcd_space(data[i])) i++;
+    return (i < len && data[i] == '$') ? SNESPAD_CAPTURE_VCD : SNESPAD_CAPTURE_CSV;
+}
+
+bool snespad_capture_map(snespad_capture_t* cap, uint8_t line, const char* name)
+{
+    size_t n = strlen(name);
+
+    for (uint8_t i = 0; i < 5; i++) {
+        if (line == 1 << i) {
+            if (n >= SNESPAD_CAPTURE_NAME_MAX) {
+                return false;
+            }
+            memcpy(cap->names[i], name, n + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void snespad_capture_set_handlers(snespad_capture_t* cap, snespad_capture_frame_fn on_frame,
+                                  snespad_capture_issue_fn on_issue, void* ctx)
+{
+    cap->on_frame = on_frame;
+    cap->on_issue = on_issue;
+    cap->ctx = ctx;
+}
+
+void snespad_capture_set_samplerate(snespad_capture_t* cap, uint64_t hz)
+{
+    cap->samplerate = hz;
+}
+
+void snespad_capture_feed(snespad_capture_t* cap, const char* data, size_t len)
+{
+    const char* p = data;
+    const char* end = data + len;
+
+    // Complete the unit the previous chunk ended in
+    if (cap->unit_len || cap->unit_long) {
+        const char* e = capture_scan(cap, p, end);
+        size_t n = e - p;
+
+        if (!cap->unit_long && cap->unit_len + n <= sizeof(cap->unit)) {
+            memcpy(cap->unit + cap->unit_len, p, n);
+            cap->unit_len += n;
+        } else {
+            cap->unit_long = true;
+        }
+        if (e == end) {
+            return;
+        }
+        if (cap->unit_long) {
+            cap->errors++;
+        } else {
+            capture_unit(cap, cap->unit, cap->unit_len);
+        }
+        cap->unit_len = 0;
+        cap->unit_long = false;
+        p = e + 1;
+    }
+
+    while (p < end) {
+        const char* e;
+
+        if (vcd_space(*p)) {
+            p++;
+            continue;
+        }
+        e = capture_scan(cap, p, end);
+        if (e == end) {
+            // Split by the chunk: keep it for the next one
+            if ((size_t)(e - p) <= sizeof(cap->unit)) {
+                memcpy(cap->unit, p, e - p);
+                cap->unit_len = e - p;
+            } else {
+                cap->unit_long = true;
+            }
+            return;
+        }
+        capture_unit(cap, p, e - p);
+        p = e + 1;
+    }
+}
+
+void snespad_capture_end(snespad_capture_t* cap)
+{
+    snespad_frame_t frame;
+
+    if (cap->unit_long) {
+        cap->errors++;
+    } else if (cap->unit_len) {
+        capture_unit(cap, cap->unit, cap->unit_len);
+    }
+    cap->unit_len = 0;
+    cap->unit_long = false;
+
+    if (cap->dirty) {
+        cap->dirty = false;
+        capture_apply(cap, vcd_ns(cap), cap->pending);
+    }
+    if (snespad_framer_flush(&cap->framer, &frame)) {
+        capture_frame(cap, &frame);
+    }
+}
+
+#endif // SNESPAD_HOST
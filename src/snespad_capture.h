@@ -0,0 +1,170 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Offline analysis of logic analyzer captures (host builds). A capture of
+  the five port lines, as a value change dump (VCD) or sigrok CSV export,
+  is fed in chunks of any size, so a multi-gigabyte file can be streamed or
+  mapped a window at a time and is never held whole. Line changes go
+  through the frame decoder (snespad_frame.h), which splits the traffic
+  into transactions with the host's own framing, and through timing checks
+  that report short latch pulses, short clock phases, data that changed
+  too close to the clock rising edge and keyboard id re-alignments.
+
+  Signals are found by name: latch, clock, data0, data1 and iobit (and a
+  few common spellings such as clk or data) unless named with
+  snespad_capture_map(). Lines missing from the capture idle at their bus
+  level (clock and the data lines high, latch low).
+
+  VCD: scalar and one-bit vector changes of wire/reg variables; the
+  timescale is honoured and times are kept in nanoseconds.
+  sigrok CSV: one row per sample. A "Time" column (seconds) is used when
+  present, otherwise row numbers at the "; Samplerate:" comment or
+  snespad_capture_set_samplerate() (1 MHz if neither). Without a header
+  row the columns are taken as latch, clock, data0, data1, iobit.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_CAPTURE_H
+#define SNESPAD_CAPTURE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "snespad_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Capture formats
+#define SNESPAD_CAPTURE_VCD     0
+#define SNESPAD_CAPTURE_CSV     1    // sigrok CSV export
+
+#define SNESPAD_CAPTURE_NAME_MAX    32   // signal name length (with the terminator)
+#define SNESPAD_CAPTURE_TOKEN_MAX   512  // longest VCD token or CSV row split across chunks
+#define SNESPAD_CAPTURE_COLUMNS     64   // CSV columns looked at
+
+// Issue kinds
+#define SNESPAD_ISSUE_SHORT_LATCH       0  // latch high shorter than limits.latch_ns
+#define SNESPAD_ISSUE_SHORT_CLOCK_LOW   1  // clock low shorter than limits.clock_low_ns
+#define SNESPAD_ISSUE_SHORT_CLOCK_HIGH  2  // clock high shorter than limits.clock_high_ns
+#define SNESPAD_ISSUE_LATE_SAMPLE       3  // data changed less than limits.setup_ns before the clock rose
+#define SNESPAD_ISSUE_RESYNC            4  // keyboard id re-aligned (width_ns and limit_ns are 0)
+#define SNESPAD_ISSUE_KINDS             5
+
+// Timing the bus must meet (nanoseconds)
+// Defaults are the slowest peripheral the simulation models (XBAND
+// keyboard). The clock rising edge is the latest point a host can sample,
+// so setup_ns is measured against it.
+typedef struct {
+    uint32_t latch_ns;
+    uint32_t clock_low_ns;
+    uint32_t clock_high_ns;
+    uint32_t setup_ns;
+} snespad_capture_limits_t;
+
+// One timing violation or keyboard resync
+typedef struct {
+    uint64_t time_ns;           // Edge that ended the short phase (latch time for a resync)
+    uint8_t kind;               // SNESPAD_ISSUE_*
+    uint8_t line;               // SNESPAD_LINE_* it was seen on
+    uint32_t width_ns;          // Measured phase or setup time
+    uint32_t limit_ns;          // Limit it fell short of
+} snespad_capture_issue_t;
+
+// Output handlers (either may be NULL)
+typedef void (*snespad_capture_frame_fn)(void* ctx, uint64_t latch_ns, const snespad_frame_t* frame);
+typedef void (*snespad_capture_issue_fn)(void* ctx, const snespad_capture_issue_t* issue);
+
+typedef struct {
+    // Settings
+    uint8_t format;             // SNESPAD_CAPTURE_*
+    char names[5][SNESPAD_CAPTURE_NAME_MAX];  // Signal name per line ("" = usual names)
+    snespad_capture_limits_t limits;
+    uint64_t samplerate;        // CSV rows per second without a time column
+    snespad_capture_frame_fn on_frame;
+    snespad_capture_issue_fn on_issue;
+    void* ctx;
+
+    // Parser
+    uint8_t state;
+    uint8_t field;              // VCD declaration field (state to resume after $end when skipping)
+    char var_id[8];             // Identifier of the VCD variable being declared
+    uint8_t var_id_len;
+    bool var_scalar;
+    uint8_t vector;             // Value of a one-bit vector waiting for its id
+    char ids[5][8];             // VCD identifier per line
+    uint8_t id_len[5];
+    uint64_t scale_mul;         // VCD time unit = scale_mul / scale_div ns
+    uint64_t scale_div;
+    uint64_t time;              // Current VCD time (capture units)
+    int8_t columns[SNESPAD_CAPTURE_COLUMNS];  // CSV column to line index (-1 = none)
+    int8_t time_column;         // CSV time column (-1 = none)
+    uint8_t ncolumns;
+    uint64_t row;               // CSV sample number
+    char unit[SNESPAD_CAPTURE_TOKEN_MAX];     // Token or row split across chunks
+    uint16_t unit_len;
+    bool unit_long;             // The split unit did not fit
+
+    // Line state
+    bool started;
+    bool dirty;                 // VCD changes at the current time not applied yet
+    uint8_t pending;            // Levels at the current time
+    uint8_t lines;              // Levels applied
+    uint8_t seen;               // Lines that changed since the start
+    uint64_t now_ns;
+    uint64_t changed_ns[5];     // Last change per line
+    uint64_t latch_ns;          // Latch of the transaction in progress
+    snespad_framer_t framer;
+
+    // Results
+    uint64_t edges;             // Line changes applied
+    uint32_t frames;            // Transactions decoded
+    uint32_t issues[SNESPAD_ISSUE_KINDS];
+    uint32_t errors;            // Malformed or oversized rows and tokens
+} snespad_capture_t;
+
+// Set up an analyzer for a format, with default limits and signal names
+void snespad_capture_init(snespad_capture_t* cap, uint8_t format);
+
+// Guess the format from the start of a capture
+// Returns: SNESPAD_CAPTURE_VCD if it starts with a VCD keyword, else SNESPAD_CAPTURE_CSV
+uint8_t snespad_capture_detect(const char* data, size_t len);
+
+// Name the signal or CSV column carrying a line (SNESPAD_LINE_*), before feeding
+// Returns: false for an unknown line or a name that is too long
+bool snespad_capture_map(snespad_capture_t* cap, uint8_t line, const char* name);
+
+// Set the handlers called for every transaction and issue
+void snespad_capture_set_handlers(snespad_capture_t* cap, snespad_capture_frame_fn on_frame,
+                                  snespad_capture_issue_fn on_issue, void* ctx);
+
+// CSV rows per second when the export has no time column or samplerate comment
+void snespad_capture_set_samplerate(snespad_capture_t* cap, uint64_t hz);
+
+// Parse the next chunk of the capture (chunks may split tokens and rows)
+void snespad_capture_feed(snespad_capture_t* cap, const char* data, size_t len);
+
+// End of the capture: apply the last changes and report the last transaction
+void snespad_capture_end(snespad_capture_t* cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_CAPTURE_H
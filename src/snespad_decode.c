@@ -0,0 +1,119 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Table-driven packet decoder: maps a packet to SNES button masks and
+  signed mouse counts the same way for every device type.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_c.h"
+#include "snespad_internal.h"
+
+// Tables live in flash; AVR needs PROGMEM and explicit reads for that
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define DECODE_ROM          PROGMEM
+#define decode_byte(p)      pgm_read_byte(p)
+#define decode_word(p)      pgm_read_word(p)
+#else
+#define DECODE_ROM
+#define decode_byte(p)      (*(p))
+#define decode_word(p)      (*(p))
+#endif
+
+#define DECODE_TYPES        4  // controller, NES, mouse, anything else
+
+// One nibble of packet bits to the button masks they stand for
+#define NIB(i, b0, b1, b2, b3) \
+    (((i) & 1 ? (b0) : 0) | ((i) & 2 ? (b1) : 0) | ((i) & 4 ? (b2) : 0) | ((i) & 8 ? (b3) : 0))
+#define NIBBLE(b0, b1, b2, b3) { \
+    NIB(0, b0, b1, b2, b3),  NIB(1, b0, b1, b2, b3),  NIB(2, b0, b1, b2, b3),  NIB(3, b0, b1, b2, b3),  \
+    NIB(4, b0, b1, b2, b3),  NIB(5, b0, b1, b2, b3),  NIB(6, b0, b1, b2, b3),  NIB(7, b0, b1, b2, b3),  \
+    NIB(8, b0, b1, b2, b3),  NIB(9, b0, b1, b2, b3),  NIB(10, b0, b1, b2, b3), NIB(11, b0, b1, b2, b3), \
+    NIB(12, b0, b1, b2, b3), NIB(13, b0, b1, b2, b3), NIB(14, b0, b1, b2, b3), NIB(15, b0, b1, b2, b3)  \
+}
+
+// Buttons from packet bits 0-3, 4-7 and 8-11, per device type
+static const uint16_t button_lut[DECODE_TYPES][3][16] DECODE_ROM = {
+    // SNES controller: bits are the masks
+    {
+        NIBBLE(SNES_B, SNES_Y, SNES_SELECT, SNES_START),
+        NIBBLE(SNES_UP, SNES_DOWN, SNES_LEFT, SNES_RIGHT),
+        NIBBLE(SNES_A, SNES_X, SNES_L, SNES_R),
+    },
+    // NES: A is at the SNES B position, B at the SNES Y position
+    {
+        NIBBLE(SNES_A, SNES_B, SNES_SELECT, SNES_START),
+        NIBBLE(SNES_UP, SNES_DOWN, SNES_LEFT, SNES_RIGHT),
+        NIBBLE(0, 0, 0, 0),
+    },
+    // Mouse: left is at the SNES X position, right at SNES A; bits 10-11
+    // are the speed
+    {
+        NIBBLE(0, 0, 0, 0),
+        NIBBLE(0, 0, 0, 0),
+        NIBBLE(SNES_A, SNES_B, 0, 0),
+    },
+    // Keyboard, no device: no buttons
+    {
+        NIBBLE(0, 0, 0, 0),
+        NIBBLE(0, 0, 0, 0),
+        NIBBLE(0, 0, 0, 0),
+    },
+};
+
+// Bit reversal of a byte
+#define R2(n)   (n), (n) + 128, (n) + 64, (n) + 192
+#define R4(n)   R2(n), R2((n) + 32), R2((n) + 16), R2((n) + 48)
+#define R6(n)   R4(n), R4((n) + 8), R4((n) + 4), R4((n) + 12)
+
+// A mouse axis byte is the sign bit followed by the magnitude MSB first,
+// so reversing it gives sign << 7 | magnitude
+static const uint8_t reverse_lut[256] DECODE_ROM = {
+    R6(0), R6(2), R6(1), R6(3)
+};
+
+// Signed count of one mouse axis byte
+static int8_t decode_axis(uint8_t axis)
+{
+    uint8_t r = decode_byte(&reverse_lut[axis]);
+    int8_t sign = -(int8_t)(r >> 7);
+
+    return ((int8_t)(r & 0x7F) ^ sign) - sign;
+}
+
+void snespad_decode_packet(int8_t type, uint32_t packet, snespad_input_t* input)
+{
+    uint8_t t = (uint8_t)type < DECODE_TYPES - 1 ? (uint8_t)type : DECODE_TYPES - 1;
+    int8_t mouse = -(int8_t)(t == SNESPAD_MOUSE);
+
+    input->buttons = decode_word(&button_lut[t][0][packet & 0x0F]) |
+                     decode_word(&button_lut[t][1][(packet >> 4) & 0x0F]) |
+                     decode_word(&button_lut[t][2][(packet >> 8) & 0x0F]);
+    input->dx = decode_axis(packet >> 24) & mouse;
+    input->dy = decode_axis(packet >> 16) & mouse;
+}
+
+uint8_t snespad_mouse_axis(int8_t count)
+{
+    uint8_t mag = count < 0 ? -count : count;
+
+    if (mag > 127) {
+        mag = 127;
+    }
+    return decode_byte(&reverse_lut[(count < 0 ? 0x80 : 0) | mag]);
+}
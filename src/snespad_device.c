@@ -0,0 +1,216 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Device mode: answer a console's latch and clock as a controller.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_device.h"
+#include "snespad_internal.h"
+
+#include <stddef.h>
+
+#define LEVELS_UNPLUGGED    0xFFFFFFFF  // line left high by the pull-up
+
+// Mouse speed index (slow -> medium -> fast) to the code sent in bits 10-11
+static const uint8_t mouse_speed_code[3] = {
+    SNES_MOUSE_SLOW, SNES_MOUSE_MEDIUM, SNES_MOUSE_FAST
+};
+
+static void device_out(snespad_device_t* dev, uint8_t level)
+{
+    dev->bus->write(dev->bus->ctx, dev->data_pin, level);
+}
+
+// Speed bits as line levels (the line is active low)
+static uint32_t device_speed_levels(const snespad_device_t* dev)
+{
+    return ~((uint32_t)mouse_speed_code[dev->mouse_speed] << 10) & SNES_MOUSE_SPEED;
+}
+
+// Line levels for the next packet, in the order they are clocked out
+static uint32_t device_levels(snespad_device_t* dev)
+{
+    uint16_t b = dev->buttons;
+    uint32_t packet;
+
+    if (dev->replay) {
+        snespad_log_record_t record;
+
+        if (!snespad_log_read(dev->replay, &record)) {
+            return LEVELS_UNPLUGGED;
+        }
+        return record.packet;
+    }
+
+    switch (dev->type) {
+        case SNESPAD_NES:
+            // NES A is at the SNES B position, B at the SNES Y position
+            packet = (b & (SNES_SELECT | SNES_START | SNES_UP | SNES_DOWN | SNES_LEFT | SNES_RIGHT)) |
+                     ((b & SNES_A) ? SNES_B : 0) |
+                     ((b & SNES_B) ? SNES_Y : 0) |
+                     0xFFFFFF00;  // reads low after 8 bits
+            return ~packet;
+
+        case SNESPAD_MOUSE: {
+            int16_t dx, dy;
+
+            snespad_motion_take(&dev->motion, &dx, &dy, 127);
+
+            // Left is at the SNES X position, right at SNES A
+            packet = ((b & SNES_A) ? SNES_A : 0) |
+                     ((b & SNES_B) ? SNES_X : 0) |
+                     (uint32_t)SNES_MOUSE_ID << 12 |
+                     (uint32_t)snespad_mouse_axis(dy) << 16 |
+                     (uint32_t)snespad_mouse_axis(dx) << 24;
+            return (~packet & ~SNES_MOUSE_SPEED) | device_speed_levels(dev);
+        }
+
+        default:
+            packet = b & SNES_BUTTONS;  // id 0
+            return ~packet & 0xFFFF;    // bits after 16 read low
+    }
+}
+
+// Latch high: build the packet (its first bit shows right away, like a
+// 4021 in parallel load); latch low: capture it for clocking out.
+// Clock rising edges shift while latch is low and cycle the mouse speed
+// while it is high.
+static void device_edge(void* arg, uint8_t pin, uint8_t level)
+{
+    snespad_device_t* dev = (snespad_device_t*)arg;
+
+    if (pin == dev->latch_pin) {
+        dev->latched = level != 0;
+        if (dev->latched) {
+            dev->latch_us = dev->bus->now_us(dev->bus->ctx);
+            dev->next = device_levels(dev);
+            dev->latches++;
+            device_out(dev, dev->next & 1);
+        } else {
+            dev->shift = dev->next;
+            dev->bit = 0;
+            device_out(dev, dev->shift & 1);
+        }
+        return;
+    }
+
+    if (!level) {
+        return;
+    }
+
+    if (dev->latched) {
+        if (dev->type == SNESPAD_MOUSE && !dev->replay) {
+            dev->mouse_speed = dev->mouse_speed < 2 ? dev->mouse_speed + 1 : 0;
+            dev->next = (dev->next & ~SNES_MOUSE_SPEED) | device_speed_levels(dev);
+        }
+        return;
+    }
+
+    if (dev->bit < 32) {
+        dev->bit++;
+        dev->clocks++;
+    }
+    device_out(dev, dev->bit < 32 ? (dev->shift >> dev->bit) & 1 : 0);
+}
+
+// ============================================================================
+// Public API Implementation
+// ============================================================================
+
+void snespad_device_init(snespad_device_t* dev, int8_t type,
+                         uint8_t clock, uint8_t latch, uint8_t data0)
+{
+    dev->bus = snespad_bus_platform();
+    dev->latch_pin = latch;
+    dev->clock_pin = clock;
+    dev->data_pin = data0;
+    dev->type = type;
+
+    dev->buttons = 0;
+    snespad_motion_init(&dev->motion);
+    dev->replay = NULL;
+
+    dev->mouse_speed = 0;
+    dev->latched = false;
+    dev->next = 0;
+    dev->shift = 0;
+    dev->bit = 32;
+    dev->latches = 0;
+    dev->latch_us = 0;
+    dev->clocks = 0;
+}
+
+void snespad_device_set_bus(snespad_device_t* dev, const snespad_bus_t* bus)
+{
+    dev->bus = bus;
+}
+
+bool snespad_device_begin(snespad_device_t* dev)
+{
+    const snespad_bus_t* bus = dev->bus;
+
+    if (!bus || !bus->attach_edge) {
+        return false;
+    }
+
+    bus->pin_mode(bus->ctx, dev->latch_pin, SNESPAD_PIN_INPUT);
+    bus->pin_mode(bus->ctx, dev->clock_pin, SNESPAD_PIN_INPUT);
+    bus->pin_mode(bus->ctx, dev->data_pin, SNESPAD_PIN_OUTPUT);
+    device_out(dev, 0);  // a connected pad holds the line low between reads
+
+    if (!bus->attach_edge(bus->ctx, dev->latch_pin, device_edge, dev)) {
+        return false;
+    }
+    if (!bus->attach_edge(bus->ctx, dev->clock_pin, device_edge, dev)) {
+        bus->attach_edge(bus->ctx, dev->latch_pin, NULL, NULL);
+        return false;
+    }
+    return true;
+}
+
+void snespad_device_end(snespad_device_t* dev)
+{
+    const snespad_bus_t* bus = dev->bus;
+
+    bus->attach_edge(bus->ctx, dev->latch_pin, NULL, NULL);
+    bus->attach_edge(bus->ctx, dev->clock_pin, NULL, NULL);
+    bus->pin_mode(bus->ctx, dev->data_pin, SNESPAD_PIN_INPUT);
+}
+
+void snespad_device_set_buttons(snespad_device_t* dev, uint16_t buttons)
+{
+    dev->buttons = buttons;
+}
+
+void snespad_device_mouse_move(snespad_device_t* dev, int16_t dx, int16_t dy)
+{
+    // The accumulator takes one report's worth (-127..127) at a time
+    while (dx || dy) {
+        int8_t x = dx > 127 ? 127 : dx < -127 ? -127 : dx;
+        int8_t y = dy > 127 ? 127 : dy < -127 ? -127 : dy;
+
+        snespad_motion_add(&dev->motion, x, y);
+        dx -= x;
+        dy -= y;
+    }
+}
+
+void snespad_device_set_replay(snespad_device_t* dev, snespad_log_t* log)
+{
+    dev->replay = log;
+}
@@ -0,0 +1,96 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Device mode: the library plays the controller. Latch and clock from a
+  console (or another host) are inputs and data0 is driven as a SNES pad,
+  NES pad or SNES mouse. All work happens in edge interrupts attached
+  through the bus: the packet is built on the latch rising edge, captured
+  on the falling edge, and every clock rising edge only shifts out the
+  next prepared bit, so each interrupt does a fixed, small amount of work
+  well inside the console's 6us clock phases.
+
+  Buttons use the same SNES_* masks as snespad_t.buttons, so a polled pad
+  can be passed straight through; a recorded log (snespad_log.h) can be
+  answered instead, bit for bit.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_DEVICE_H
+#define SNESPAD_DEVICE_H
+
+#include "snespad_c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    const snespad_bus_t* bus;
+    uint8_t latch_pin;          // Input
+    uint8_t clock_pin;          // Input
+    uint8_t data_pin;           // Output (data0)
+    int8_t type;                // SNESPAD_CONTROLLER, SNESPAD_NES or SNESPAD_MOUSE
+
+    // Main loop side
+    volatile uint16_t buttons;  // SNES_* masks (NES A/B as SNES_A/SNES_B,
+                                // mouse left/right as SNES_B/SNES_A)
+    snespad_motion_t motion;    // Mouse motion not sent yet
+    snespad_log_t* replay;      // Answer with recorded packets (NULL = off)
+
+    // Interrupt side
+    uint8_t mouse_speed;        // Speed index: 0 = slow, 1 = medium, 2 = fast
+    bool latched;
+    uint32_t next;              // Line levels prepared while latch is high
+    uint32_t shift;             // Line levels being clocked out
+    uint8_t bit;                // Bit on the line (32 = done, line low)
+
+    volatile uint32_t latches;  // Latch pulses answered
+    volatile uint32_t latch_us; // Bus time of the last latch rising edge
+    volatile uint32_t clocks;   // Clock edges shifted
+} snespad_device_t;
+
+// Initialize device mode for a controller type on the given pins
+// (uses the platform bus; see snespad_device_set_bus)
+void snespad_device_init(snespad_device_t* dev, int8_t type,
+                         uint8_t clock, uint8_t latch, uint8_t data0);
+
+// Replace the bus transport (needs attach_edge; call before begin)
+void snespad_device_set_bus(snespad_device_t* dev, const snespad_bus_t* bus);
+
+// Configure the pins and attach the latch and clock edge handlers
+// Returns: false if the bus cannot interrupt on those pins
+bool snespad_device_begin(snespad_device_t* dev);
+
+// Detach the handlers and release the data line
+void snespad_device_end(snespad_device_t* dev);
+
+// Buttons sent from the next latch on (SNES_* masks)
+void snespad_device_set_buttons(snespad_device_t* dev, uint16_t buttons);
+
+// Add mouse motion; each latch sends up to 127 counts per axis and keeps
+// the rest for the following ones
+void snespad_device_mouse_move(snespad_device_t* dev, int16_t dx, int16_t dy);
+
+// Answer each latch with the next packet of a recorded log instead of the
+// buttons (NULL to go back); after the log ends the line reads unplugged
+void snespad_device_set_replay(snespad_device_t* dev, snespad_log_t* log);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_DEVICE_H
@@ -0,0 +1,66 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Input event queue.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_events.h"
+#include "snespad_internal.h"
+
+// The producer writes head, the consumer writes tail
+#define QUEUE_MASK (SNESPAD_EVENT_QUEUE_SIZE - 1)
+
+void snespad_event_queue_init(snespad_event_queue_t* queue)
+{
+    queue->head = 0;
+    queue->tail = 0;
+    queue->dropped = 0;
+}
+
+bool snespad_event_push(snespad_event_queue_t* queue, const snespad_event_t* event)
+{
+    uint8_t head = queue->head;
+
+    if ((uint8_t)(head - load_acquire(&queue->tail)) >= SNESPAD_EVENT_QUEUE_SIZE) {
+        queue->dropped++;
+        return false;
+    }
+
+    queue->events[head & QUEUE_MASK] = *event;
+    store_release(&queue->head, (uint8_t)(head + 1));
+    return true;
+}
+
+bool snespad_event_pop(snespad_event_queue_t* queue, snespad_event_t* event)
+{
+    uint8_t tail = queue->tail;
+
+    if (tail == load_acquire(&queue->head)) {
+        return false;
+    }
+
+    *event = queue->events[tail & QUEUE_MASK];
+    store_release(&queue->tail, (uint8_t)(tail + 1));
+    return true;
+}
+
+uint8_t snespad_event_count(const snespad_event_queue_t* queue)
+{
+    uint8_t tail = load_acquire(&queue->tail);
+    return (uint8_t)(load_acquire(&queue->head) - tail);
+}
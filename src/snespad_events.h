@@ -0,0 +1,94 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Input event queue. A poll that sees a button, mouse, key or connection
+  change pushes typed, timestamped events into a fixed-size ring shared by
+  one producer (the context calling snespad_poll) and one consumer (for
+  example the USB report code), without locks or allocation.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_EVENTS_H
+#define SNESPAD_EVENTS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Queue capacity (power of two, at most 128 so free-running 8-bit
+// indices can tell full from empty)
+#ifndef SNESPAD_EVENT_QUEUE_SIZE
+#define SNESPAD_EVENT_QUEUE_SIZE 32
+#endif
+
+#if (SNESPAD_EVENT_QUEUE_SIZE & (SNESPAD_EVENT_QUEUE_SIZE - 1)) || \
+    SNESPAD_EVENT_QUEUE_SIZE < 2 || SNESPAD_EVENT_QUEUE_SIZE > 128
+#error "SNESPAD_EVENT_QUEUE_SIZE must be a power of two from 2 to 128"
+#endif
+
+// Event types
+#define SNESPAD_EVENT_BUTTON_DOWN   0  // code = button mask (SNES_*)
+#define SNESPAD_EVENT_BUTTON_UP     1  // code = button mask (SNES_*)
+#define SNESPAD_EVENT_MOUSE_MOVE    2  // dx, dy = mouse_x/mouse_y offset from center
+#define SNESPAD_EVENT_KEY_DOWN      3  // code = scancode | SNESPAD_EVENT_KEY_SPECIAL
+#define SNESPAD_EVENT_KEY_UP        4  // code = scancode | SNESPAD_EVENT_KEY_SPECIAL
+#define SNESPAD_EVENT_ATTACH        5  // code = device type detected
+#define SNESPAD_EVENT_DETACH        6  // code = device type that was lost
+#define SNESPAD_EVENT_RUMBLE        7  // code = LRG rumble byte, right << 4 | left (sniffer)
+
+// Key code flag: scancode was preceded by SNES_KEY_SPECIAL (0xE0)
+#define SNESPAD_EVENT_KEY_SPECIAL   0x0100
+
+// Input event
+typedef struct {
+    uint32_t time_us;   // Bus clock time of the latch that sampled it
+    uint8_t type;       // SNESPAD_EVENT_*
+    uint8_t port;       // Port number given to snespad_set_event_queue
+    uint16_t code;      // Button mask, key code or device type
+    int16_t dx;         // Mouse motion (SNESPAD_EVENT_MOUSE_MOVE)
+    int16_t dy;
+} snespad_event_t;
+
+// Single-producer/single-consumer ring
+typedef struct snespad_event_queue {
+    snespad_event_t events[SNESPAD_EVENT_QUEUE_SIZE];
+    uint8_t head;       // Next slot to write (producer)
+    uint8_t tail;       // Next slot to read (consumer)
+    uint16_t dropped;   // Events lost to a full queue (producer)
+} snespad_event_queue_t;
+
+// Initialize an empty queue
+void snespad_event_queue_init(snespad_event_queue_t* queue);
+
+// Producer: append an event. Returns false (and counts it as dropped)
+// if the queue is full.
+bool snespad_event_push(snespad_event_queue_t* queue, const snespad_event_t* event);
+
+// Consumer: take the oldest event. Returns false if the queue is empty.
+bool snespad_event_pop(snespad_event_queue_t* queue, snespad_event_t* event);
+
+// Number of events waiting (safe from either side)
+uint8_t snespad_event_count(const snespad_event_queue_t* queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_EVENTS_H
@@ -0,0 +1,203 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Frame decoder for observed bus traffic.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_frame.h"
+#include "snespad_c.h"
+
+#include <string.h>
+
+// Decoder phases
+#define FRAME_IDLE      0  // waiting for a latch
+#define FRAME_LATCH     1  // latch high, clocks are speed pulses
+#define FRAME_BITS      2  // data bits
+#define FRAME_KB_WAIT   3  // data bits done, keyboard if IOBit is low
+#define FRAME_KB        4  // keyboard dibits
+
+// Keyboard stages (same order as the host transaction)
+#define STAGE_ID        0
+#define STAGE_COUNT     1
+#define STAGE_DATA      2
+
+static bool framer_finish(snespad_framer_t* framer, snespad_frame_t* frame)
+{
+    snespad_frame_t* f = &framer->frame;
+
+    if (framer->phase == FRAME_IDLE) {
+        return false;
+    }
+    framer->phase = FRAME_IDLE;
+    framer->last_keyboard = f->keyboard && f->kid == SNES_KEYBOARD_ID;
+    *frame = *f;
+    return true;
+}
+
+// One keyboard dibit (data0 | data1 << 1), with the host's recovery rules
+// Returns: true once the transaction is complete
+static bool framer_dibit(snespad_framer_t* framer, uint8_t bits)
+{
+    snespad_frame_t* f = &framer->frame;
+
+    switch (framer->stage) {
+        case STAGE_ID:
+            f->kid |= bits << framer->index;
+            framer->index += 2;
+
+            // The keyboard was a dibit ahead
+            if (framer->index == 6 && f->kid == (SNES_KEYBOARD_ID >> 2)) {
+                f->kid <<= 2;
+                framer->index = 8;
+                f->resync = true;
+            }
+            if (framer->index == 8) {
+                framer->stage = STAGE_COUNT;
+                framer->index = 0;
+            }
+            return false;
+
+        case STAGE_COUNT:
+            f->num |= bits << framer->index;
+            framer->index += 2;
+            if (framer->index < 4) {
+                return false;
+            }
+            f->num &= 0x0F;
+
+            // Random bad id from a keyboard that was there a moment ago
+            if (framer->last_keyboard && f->kid == SNES_KEYBOARD_ID + 1) {
+                f->kid = SNES_KEYBOARD_ID;
+                f->resync = true;
+            }
+            if (!f->num || f->kid != SNES_KEYBOARD_ID) {
+                return true;
+            }
+            framer->stage = STAGE_DATA;
+            framer->index = 0;
+            framer->byte = 0;
+            return false;
+
+        default:
+            framer->byte |= bits << framer->index;
+            framer->index += 2;
+            if (framer->index < 8) {
+                return false;
+            }
+            f->scancodes[f->scancodes_len++] = framer->byte;
+            framer->byte = 0;
+            framer->index = 0;
+            return f->scancodes_len >= f->num;
+    }
+}
+
+void snespad_framer_init(snespad_framer_t* framer)
+{
+    framer->lines = 0;
+    framer->phase = FRAME_IDLE;
+    framer->last_keyboard = false;
+}
+
+bool snespad_framer_edge(snespad_framer_t* framer, uint32_t time_us, uint8_t lines,
+                         snespad_frame_t* frame)
+{
+    snespad_frame_t* f = &framer->frame;
+    uint8_t prev = framer->lines;
+    bool clock_rose = (lines & ~prev) & SNESPAD_LINE_CLOCK;
+
+    framer->lines = lines;
+
+    // A latch ends the previous transaction and starts the next one
+    if ((lines & ~prev) & SNESPAD_LINE_LATCH) {
+        bool done = framer_finish(framer, frame);
+
+        memset(f, 0, sizeof(*f));
+        f->latch_us = time_us;
+        f->end_us = time_us;
+        f->disconnected = (prev & SNESPAD_LINE_DATA0) != 0;
+        framer->phase = FRAME_LATCH;
+        return done;
+    }
+
+    switch (framer->phase) {
+        case FRAME_LATCH:
+            if (!(lines & SNESPAD_LINE_LATCH)) {
+                framer->phase = FRAME_BITS;
+            } else if (clock_rose) {
+                f->speed_pulses++;
+            }
+            return false;
+
+        // Data is read from the levels at the end of each clock low phase
+        case FRAME_BITS:
+            if (!clock_rose) {
+                return false;
+            }
+            f->end_us = time_us;
+            f->packet |= (uint32_t)((prev & SNESPAD_LINE_DATA0) != 0) << f->bits;
+            if (f->bits < 16) {
+                f->iobit = (f->iobit << 1) | ((prev & SNESPAD_LINE_IOBIT) != 0);
+            }
+            f->bits++;
+
+            // Bit 15 low is the mouse id, which has 16 more bits
+            if ((f->bits == 16 && (f->packet >> 15) & 1) || f->bits == 32) {
+                framer->phase = FRAME_KB_WAIT;
+            }
+            return false;
+
+        case FRAME_KB_WAIT:
+            if (!clock_rose) {
+                return false;
+            }
+            f->end_us = time_us;
+            if (prev & SNESPAD_LINE_IOBIT) {
+                if (f->extra_clocks < 255) f->extra_clocks++;
+                return false;
+            }
+            f->keyboard = true;
+            framer->stage = STAGE_ID;
+            framer->index = 0;
+            framer->phase = FRAME_KB;
+            // fall through
+
+        case FRAME_KB:
+            if (!clock_rose) {
+                return false;
+            }
+            f->end_us = time_us;
+            if (!framer_dibit(framer, ((prev & SNESPAD_LINE_DATA0) ? 1 : 0) |
+                                      ((prev & SNESPAD_LINE_DATA1) ? 2 : 0))) {
+                return false;
+            }
+            return framer_finish(framer, frame);
+
+        default:
+            return false;
+    }
+}
+
+bool snespad_framer_flush(snespad_framer_t* framer, snespad_frame_t* frame)
+{
+    return framer_finish(framer, frame);
+}
+
+void snespad_framer_reset(snespad_framer_t* framer)
+{
+    framer->phase = FRAME_IDLE;
+}
@@ -0,0 +1,100 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Frame decoder for observed bus traffic. Fed the five port lines after
+  every edge, it splits the traffic into transactions (latch to the next
+  latch) with the same framing snespad_poll() uses as the host. Data is
+  taken at each clock rising edge from the levels just before it (the end
+  of the low phase, where the host samples and before the device shifts);
+  16 bits are extended to 32 when bit 15 reads low (mouse), clock pulses
+  while latch is high are mouse speed cycling, and clocks after the data
+  bits with IOBit held low are an XBAND keyboard transaction (id, count
+  and scancode dibits on data0/data1). IOBit during the first 16 clocks
+  carries LRG rumble frames.
+
+  Used by the sniffer (snespad_sniff.h) on live edges and by offline
+  capture analysis on the host (snespad_capture.h).
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_FRAME_H
+#define SNESPAD_FRAME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Port lines as bits of a line sample
+#define SNESPAD_LINE_LATCH  0x01
+#define SNESPAD_LINE_CLOCK  0x02
+#define SNESPAD_LINE_DATA0  0x04
+#define SNESPAD_LINE_DATA1  0x08
+#define SNESPAD_LINE_IOBIT  0x10
+
+// One transaction seen on the bus
+typedef struct {
+    uint32_t latch_us;          // Latch rising edge
+    uint32_t end_us;            // Last clock rising edge (latch_us if none)
+    uint32_t packet;            // Raw data0 levels, bit i = i-th bit clocked in
+    uint8_t bits;               // Data bits clocked (16 or 32 for a full read)
+    uint8_t speed_pulses;       // Clock pulses while latch was high
+    bool disconnected;          // data0 idle high before the latch
+    uint16_t iobit;             // IOBit at the first 16 clocks, first bit in bit 15
+    bool keyboard;              // Keyboard transaction (IOBit low after the data bits)
+    bool resync;                // Keyboard id re-aligned (dibit slip or bad id)
+    uint8_t kid;                // Keyboard id
+    uint8_t num;                // Scancode count sent by the keyboard
+    uint8_t scancodes_len;      // Scancodes clocked in
+    uint8_t scancodes[16];
+    uint8_t extra_clocks;       // Clocks that did not belong to the framing
+} snespad_frame_t;
+
+// Decoder state
+typedef struct {
+    uint8_t lines;              // Line sample of the previous edge
+    uint8_t phase;
+    uint8_t stage;              // Keyboard stage
+    uint8_t index;              // Bit index within the keyboard field
+    uint8_t byte;               // Scancode being assembled
+    bool last_keyboard;         // Previous transaction read a keyboard id
+    snespad_frame_t frame;      // Transaction in progress
+} snespad_framer_t;
+
+// Start with no transaction in progress and all lines low
+void snespad_framer_init(snespad_framer_t* framer);
+
+// Feed the line sample taken right after an edge
+// Returns: true if a transaction completed (copied to frame); one ends at
+// the next latch, or as soon as its keyboard transaction is complete
+bool snespad_framer_edge(snespad_framer_t* framer, uint32_t time_us, uint8_t lines,
+                         snespad_frame_t* frame);
+
+// End the transaction in progress (bus idle, end of a capture)
+// Returns: true if there was one (copied to frame)
+bool snespad_framer_flush(snespad_framer_t* framer, snespad_frame_t* frame);
+
+// Drop the transaction in progress (edges were lost)
+void snespad_framer_reset(snespad_framer_t* framer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_FRAME_H
@@ -0,0 +1,359 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Multi-port polling with a shared latch and clock.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_group.h"
+#include "snespad_internal.h"
+
+// Unused optional pins are stored as (uint8_t)-1
+#define PIN_UNUSED 0xFF
+
+static inline uint32_t pin_bit(uint8_t pin)
+{
+    return pin < 32 ? (uint32_t)1 << pin : 0;
+}
+
+static inline uint32_t group_read(snespad_group_t* group)
+{
+    const snespad_bus_t* bus = group->port[0]->bus;
+    return bus->read_mask(bus->ctx, group->data_mask);
+}
+
+// Shared clock cycle: drive low, sample every data line, drive high
+static uint32_t group_clock(snespad_group_t* group)
+{
+    snespad_t* lead = group->port[0];
+    const snespad_timing_t* t = &group->timing;
+    uint32_t levels;
+
+    gpio_write(lead, lead->clock_pin, 0);
+    delay_us(lead, t->sample_us);
+    levels = group_read(group);
+    if (t->clock_low_us > t->sample_us) {
+        delay_us(lead, t->clock_low_us - t->sample_us);
+    }
+    gpio_write(lead, lead->clock_pin, 1);
+    delay_us(lead, t->clock_high_us);
+
+    return levels;
+}
+
+// Shared clock timing must satisfy the slowest device on the bus
+static void group_timing(snespad_group_t* group)
+{
+    snespad_timing_t* t = &group->timing;
+
+    *t = *snespad_timing(group->port[0]);
+    for (uint8_t p = 1; p < group->count; p++) {
+        const snespad_timing_t* pt = snespad_timing(group->port[p]);
+
+        if (pt->latch_us > t->latch_us) t->latch_us = pt->latch_us;
+        if (pt->clock_low_us > t->clock_low_us) t->clock_low_us = pt->clock_low_us;
+        if (pt->clock_high_us > t->clock_high_us) t->clock_high_us = pt->clock_high_us;
+        if (pt->sample_us > t->sample_us) t->sample_us = pt->sample_us;
+    }
+}
+
+// Packet clocked in on one pin, gathered bit by bit from the bank samples
+static uint32_t group_gather(const snespad_group_t* group, uint8_t pin)
+{
+    uint32_t dat = 0;
+
+    for (uint8_t i = 0; i < group->sample_count; i++) {
+        dat |= ((group->bits[i] >> pin) & 1) << i;
+    }
+    return dat;
+}
+
+static void group_transfer(snespad_group_t* group, bool detect)
+{
+    snespad_t* lead = group->port[0];
+    const snespad_timing_t* t = &group->timing;
+    uint8_t votes[3] = { 0, 0, 0 };
+    uint8_t pulses = 0;
+    bool read_extra = false;
+    bool keyboard = true;
+    bool transpose;
+    uint32_t levels;
+    uint32_t now;
+    uint8_t p, i;
+
+    group_timing(group);
+
+    for (p = 0; p < group->count; p++) {
+        snespad_t* pad = group->port[p];
+
+        snespad_clear_edges(pad);
+        snespad_xfer_begin(pad, detect || pad->type == SNESPAD_NONE ? XFER_MODE_START : XFER_MODE_POLL);
+
+        if (pad->type == SNESPAD_MOUSE && !pad->mouse_speed_unsupported) {
+            votes[snespad_mouse_speed_pulses(pad)]++;
+        }
+    }
+
+    // Mice share the speed pulses, so send the count that brings the most
+    // of them to their requested speed (fewest pulses on a tie)
+    for (i = 1; i < 3; i++) {
+        if (votes[i] > votes[pulses]) {
+            pulses = i;
+        }
+    }
+    for (p = 0; p < group->count; p++) {
+        snespad_t* pad = group->port[p];
+
+        if (pad->type == SNESPAD_MOUSE && !pad->mouse_speed_unsupported) {
+            pad->mouse_speed_pulses = pulses;
+        }
+    }
+
+    // A connected device will pull the data line low prior to latch
+    levels = group_read(group);
+    now = bus_now_us(lead);
+    for (p = 0; p < group->count; p++) {
+        group->port[p]->xfer.disconnected = (levels >> group->port[p]->data0_pin) & 1;
+        group->port[p]->xfer.latch_us = now;
+    }
+
+    // Latch to start read
+    gpio_write(lead, lead->latch_pin, 1);
+    delay_us(lead, t->latch_us);
+    for (i = 0; i < pulses; i++) {
+        // Signal mice to change speed
+        gpio_write(lead, lead->clock_pin, 0);
+        delay_us(lead, t->clock_low_us > 1 ? t->clock_low_us / 2 : 1);
+        gpio_write(lead, lead->clock_pin, 1);
+        delay_us(lead, t->clock_high_us);
+    }
+    gpio_write(lead, lead->latch_pin, 0);
+    delay_us(lead, t->latch_us);
+
+    // 16 clocks, or 32 if any port has a mouse or NES pad (bit 15 low)
+    for (i = 0; i < 32; i++) {
+        for (p = 0; p < group->count; p++) {
+            snespad_rumble_bit(group->port[p]);
+        }
+
+        group->bits[i] = group_clock(group);
+
+        if (i == 15) {
+            for (p = 0; p < group->count; p++) {
+                if (!((group->bits[15] >> group->port[p]->data0_pin) & 1)) {
+                    read_extra = true;
+                }
+            }
+            if (!read_extra) {
+                i++;
+                break;
+            }
+            delay_us(lead, t->clock_high_us);
+        }
+    }
+    group->sample_count = i;
+    for (; i < 32; i++) {
+        group->bits[i] = 0;
+    }
+
+    // A few ports are cheaper to gather than the whole bank to transpose
+    transpose = group->count >= SNESPAD_GROUP_TRANSPOSE_PORTS;
+    if (transpose) {
+        snespad_transpose32(group->bits);
+    }
+
+    for (p = 0; p < group->count; p++) {
+        snespad_t* pad = group->port[p];
+        snespad_xfer_t* x = &pad->xfer;
+
+        x->dat = transpose ? group->bits[pad->data0_pin] : group_gather(group, pad->data0_pin);
+        if ((x->dat >> 15) & 1) {
+            x->dat &= 0xFFFF;  // port stopped after 16 bits on its own
+        }
+
+        // Check and read keyboard (all ports at once)
+        gpio_write(pad, pad->iobit_pin, 0);
+        x->stage = KB_STAGE_ID;
+        x->index = 0;
+        x->kid = 0;
+        x->num = 0;
+        x->phase = XFER_KB_LOW;
+    }
+
+    while (keyboard) {
+        levels = group_clock(group);
+
+        keyboard = false;
+        for (p = 0; p < group->count; p++) {
+            snespad_t* pad = group->port[p];
+            uint8_t bits;
+
+            if (pad->xfer.phase != XFER_KB_LOW) continue;
+
+            bits = (levels >> pad->data0_pin) & 1;
+            if (pad->data1_pin != PIN_UNUSED) {
+                bits |= ((levels >> pad->data1_pin) & 1) << 1;
+            }
+            snespad_kb_dibit(pad, bits);
+            snespad_kb_next(pad);
+
+            if (pad->xfer.phase == XFER_KB_LOW) {
+                keyboard = true;
+            }
+        }
+    }
+
+    for (p = 0; p < group->count; p++) {
+        snespad_xfer_complete(group->port[p]);
+    }
+    for (p = 0; p < group->count; p++) {
+        snespad_poll_done(group->port[p]);
+    }
+}
+
+// Transpose an 8x8 bit tile held as 8 row bytes (LSB = column 0)
+// Hacker's Delight transpose8rS32 with row order flipped for LSB-first bits.
+static inline void transpose8(uint8_t* t)
+{
+    uint32_t x, y, s;
+
+    x = ((uint32_t)t[7] << 24) | ((uint32_t)t[6] << 16) | ((uint32_t)t[5] << 8) | t[4];
+    y = ((uint32_t)t[3] << 24) | ((uint32_t)t[2] << 16) | ((uint32_t)t[1] << 8) | t[0];
+
+    s = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ s ^ (s << 7);
+    s = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ s ^ (s << 7);
+    s = (x ^ (x >> 14)) & 0x0000CCCC; x = x ^ s ^ (s << 14);
+    s = (y ^ (y >> 14)) & 0x0000CCCC; y = y ^ s ^ (s << 14);
+
+    s = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = s;
+
+    t[7] = x >> 24; t[6] = x >> 16; t[5] = x >> 8; t[4] = x;
+    t[3] = y >> 24; t[2] = y >> 16; t[1] = y >> 8; t[0] = y;
+}
+
+void snespad_transpose32(uint32_t a[32])
+{
+    uint32_t m = 0x0000FFFF;
+    uint32_t t;
+    unsigned j, k;
+
+    // Swap the off-diagonal j x j blocks of every 2j x 2j block
+    for (j = 16; j != 0; j >>= 1, m ^= m << j) {
+        for (k = 0; k < 32; k = (k + j + 1) & ~j) {
+            t = ((a[k] >> j) ^ a[k + j]) & m;
+            a[k] ^= t << j;
+            a[k + j] ^= t;
+        }
+    }
+}
+
+void snespad_transpose32_bytes(uint32_t a[32])
+{
+    uint32_t in[32];
+    uint8_t t[8];
+    uint8_t r, c, i;
+
+    for (i = 0; i < 32; i++) {
+        in[i] = a[i];
+        a[i] = 0;
+    }
+
+    // Tile (r, c) holds byte c of rows 8r..8r+7 and moves to (c, r)
+    for (r = 0; r < 4; r++) {
+        for (c = 0; c < 4; c++) {
+            for (i = 0; i < 8; i++) {
+                t[i] = in[8 * r + i] >> (8 * c);
+            }
+
+            transpose8(t);
+
+            for (i = 0; i < 8; i++) {
+                a[8 * c + i] |= (uint32_t)t[i] << (8 * r);
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Public API Implementation
+// ============================================================================
+
+void snespad_group_init(snespad_group_t* group)
+{
+    group->count = 0;
+    group->data_mask = 0;
+    group->sample_count = 0;
+}
+
+int snespad_group_add(snespad_group_t* group, snespad_t* pad)
+{
+    snespad_t* lead = group->count ? group->port[0] : pad;
+    uint32_t mask;
+
+    if (group->count >= SNESPAD_GROUP_MAX_PORTS) {
+        return -1;
+    }
+
+    if (pad->clock_pin != lead->clock_pin ||
+        pad->latch_pin != lead->latch_pin ||
+        pad->bus != lead->bus) {
+        return -1;
+    }
+
+    if (pad->data0_pin >= 32 || (pad->data1_pin >= 32 && pad->data1_pin != PIN_UNUSED)) {
+        return -1;
+    }
+
+    if (pad->data1_pin == pad->data0_pin) {
+        return -1;
+    }
+
+    mask = pin_bit(pad->data0_pin) | pin_bit(pad->data1_pin);
+    if (group->data_mask & mask) {
+        return -1;  // data line already used by another port
+    }
+
+    group->data_mask |= mask;
+    group->port[group->count] = pad;
+    return group->count++;
+}
+
+void snespad_group_begin(snespad_group_t* group)
+{
+    for (uint8_t p = 0; p < group->count; p++) {
+        snespad_begin(group->port[p]);
+    }
+}
+
+void snespad_group_start(snespad_group_t* group)
+{
+    if (!group->count) return;
+
+    for (uint8_t p = 0; p < group->count; p++) {
+        group->port[p]->type = SNESPAD_NONE;
+    }
+    group_transfer(group, true);
+}
+
+void snespad_group_poll(snespad_group_t* group)
+{
+    if (!group->count) return;
+
+    group_transfer(group, false);
+}
@@ -0,0 +1,95 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Multi-port polling. Pads in a group share one latch and clock pair and
+  have their own data pins; every clock edge samples all data lines with
+  a single GPIO bank read, so a group of pads costs the bus time of the
+  slowest one instead of the sum of all of them.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_GROUP_H
+#define SNESPAD_GROUP_H
+
+#include "snespad_c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SNESPAD_GROUP_MAX_PORTS  16
+
+// Ports at which decoding switches from per-bit gathering to the 32x32
+// transpose: gathering grows with the port count, the transpose costs the
+// same for any count (extras/bench/transpose_bench.c, about 5 ports)
+#ifndef SNESPAD_GROUP_TRANSPOSE_PORTS
+#define SNESPAD_GROUP_TRANSPOSE_PORTS  5
+#endif
+
+// Pads sharing a latch and clock
+typedef struct {
+    snespad_t* port[SNESPAD_GROUP_MAX_PORTS];
+    uint8_t count;
+
+    uint32_t data_mask;         // data0/data1 pins of every port (bank bits)
+    snespad_timing_t timing;    // Timing used by the last transfer (slowest port)
+    uint32_t bits[32];          // GPIO bank level on each clock; after decode of
+                                // SNESPAD_GROUP_TRANSPOSE_PORTS or more ports,
+                                // the packet clocked in on each pin
+    uint8_t sample_count;       // Clocks in the last transfer (16 or 32)
+} snespad_group_t;
+
+// Initialize an empty group
+void snespad_group_init(snespad_group_t* group);
+
+// Add a pad set up with snespad_init() (and snespad_set_bus(), if used).
+// The pad must use the same clock, latch and bus as the group's first pad,
+// and its data pins must be GPIO 0-31 so one bank read covers them. No
+// data line may be shared: data0 and data1 differ and neither is a data
+// pin of another port.
+// Returns: port index, or -1 if the pad cannot join the group
+int snespad_group_add(snespad_group_t* group, snespad_t* pad);
+
+// Initialize GPIO for every pad in the group
+void snespad_group_begin(snespad_group_t* group);
+
+// Detect the device on every port
+void snespad_group_start(snespad_group_t* group);
+
+// Read every port with one shared latch and clock sequence and update
+// each pad's state as snespad_poll() would. Ports that report nothing are
+// set to SNESPAD_NONE and re-detected on the next group poll.
+void snespad_group_poll(snespad_group_t* group);
+
+// ============================================================================
+// Bit Matrix Transpose
+// ============================================================================
+// Turns 32 GPIO bank samples (a[i] bit p = pin p on clock i) into 32
+// per-pin packets (a[p] bit i = pin p on clock i), in place.
+
+// Word-parallel: five passes of masked block swaps on whole 32-bit rows
+void snespad_transpose32(uint32_t a[32]);
+
+// Portable: sixteen 8x8 byte tiles, each transposed with 32-bit shifts
+// and masks (no 64-bit arithmetic), suited to 8-bit targets
+void snespad_transpose32_bytes(uint32_t a[32]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_GROUP_H
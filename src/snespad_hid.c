@@ -0,0 +1,302 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  USB HID boot keyboard report builder.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_hid.h"
+
+#define USAGE_LEFT_CTRL   0xE0  // first modifier usage
+
+// Slots hold keys rather than usages: Enter and JOY-A share one usage, and
+// releasing one of them must not release the usage while the other is held
+static uint8_t hid_usage(uint16_t key)
+{
+    return snespad_key_usage(key & 0xFF, (key & SNESPAD_KEY_SPECIAL) != 0);
+}
+
+// Rewrite all key slots (rollover state changed)
+static void hid_write_slots(snespad_hid_keyboard_t* hid)
+{
+    for (uint8_t i = 0; i < SNESPAD_HID_KEY_SLOTS; i++) {
+        if (hid->pending_count) {
+            hid->report[2 + i] = SNESPAD_HID_ROLLOVER;
+        } else {
+            hid->report[2 + i] = i < hid->count ? hid_usage(hid->keys[i]) : 0;
+        }
+    }
+    hid->changed = true;
+}
+
+// Drop bit i of a slot mask, moving the higher slots down
+static uint8_t hid_remove_bit(uint8_t mask, uint8_t i)
+{
+    uint8_t low = (1 << i) - 1;
+
+    return (mask & low) | ((mask >> 1) & ~low);
+}
+
+// Remove slot i, keeping the remaining keys packed in press order
+static void hid_remove_slot(snespad_hid_keyboard_t* hid, uint8_t i)
+{
+    hid->count--;
+    for (; i < hid->count; i++) {
+        hid->keys[i] = hid->keys[i + 1];
+        if (!hid->pending_count) {
+            hid->report[2 + i] = hid_usage(hid->keys[i]);
+        }
+    }
+    hid->keys[hid->count] = 0;
+    if (!hid->pending_count) {
+        hid->report[2 + hid->count] = 0;
+    }
+    hid->changed = true;
+}
+
+static int8_t hid_find_pending(const snespad_hid_keyboard_t* hid, uint16_t key)
+{
+    for (uint8_t i = 0; i < hid->pending_count; i++) {
+        if (hid->pending[i] == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void hid_remove_pending(snespad_hid_keyboard_t* hid, uint8_t i)
+{
+    hid->pending_count--;
+    for (; i < hid->pending_count; i++) {
+        hid->pending[i] = hid->pending[i + 1];
+    }
+    hid->pending[hid->pending_count] = 0;
+}
+
+// Move waiting keys into freed slots; once everything held fits, the
+// report shows the keys again instead of rollover
+static void hid_fill_slots(snespad_hid_keyboard_t* hid)
+{
+    if (!hid->pending_count) {
+        return;
+    }
+
+    while (hid->count < SNESPAD_HID_KEY_SLOTS && hid->pending_count) {
+        hid->keys[hid->count] = hid->pending[0];
+        hid->fresh_keys |= 1 << hid->count;
+        hid->count++;
+        hid_remove_pending(hid, 0);
+    }
+
+    if (!hid->pending_count) {
+        hid_write_slots(hid);
+    }
+}
+
+static int8_t hid_find_slot(const snespad_hid_keyboard_t* hid, uint16_t key)
+{
+    for (uint8_t i = 0; i < hid->count; i++) {
+        if (hid->keys[i] == key) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void hid_press(snespad_hid_keyboard_t* hid, uint16_t key, uint8_t usage)
+{
+    int8_t slot;
+
+    if (usage >= USAGE_LEFT_CTRL) {
+        uint8_t bit = 1 << (usage - USAGE_LEFT_CTRL);
+
+        hid->release_mods &= ~bit;  // pressed again before a held back release
+        if (!(hid->report[0] & bit)) {
+            hid->report[0] |= bit;
+            hid->fresh_mods |= bit;
+            hid->changed = true;
+        }
+        return;
+    }
+
+    slot = hid_find_slot(hid, key);
+    if (slot >= 0) {
+        hid->release_keys &= ~(1 << slot);
+        return;
+    }
+
+    if (hid->count == SNESPAD_HID_KEY_SLOTS) {
+        // Keys past the pending list are not tracked (rollover stays up
+        // until the list drains)
+        if (hid_find_pending(hid, key) < 0 && hid->pending_count < SNESPAD_HID_PENDING) {
+            hid->pending[hid->pending_count++] = key;
+            if (hid->pending_count == 1) {
+                hid_write_slots(hid);
+            }
+        }
+        return;
+    }
+
+    hid->keys[hid->count] = key;
+    hid->fresh_keys |= 1 << hid->count;
+    if (!hid->pending_count) {
+        hid->report[2 + hid->count] = usage;
+        hid->changed = true;
+    }
+    hid->count++;
+}
+
+static void hid_release(snespad_hid_keyboard_t* hid, uint16_t key, uint8_t usage)
+{
+    int8_t slot;
+
+    if (usage >= USAGE_LEFT_CTRL) {
+        uint8_t bit = 1 << (usage - USAGE_LEFT_CTRL);
+
+        if (hid->fresh_mods & bit) {
+            hid->release_mods |= bit;  // host has not seen it yet
+        } else if (hid->report[0] & bit) {
+            hid->report[0] &= ~bit;
+            hid->changed = true;
+        }
+        return;
+    }
+
+    slot = hid_find_slot(hid, key);
+    if (slot < 0) {
+        // One of the keys that did not fit (or one never pressed)
+        slot = hid_find_pending(hid, key);
+        if (slot >= 0) {
+            hid_remove_pending(hid, slot);
+            if (!hid->pending_count) {
+                hid_write_slots(hid);
+            }
+        }
+        return;
+    }
+
+    if (hid->fresh_keys & (1 << slot)) {
+        hid->release_keys |= 1 << slot;
+    } else {
+        hid_remove_slot(hid, slot);
+        hid->release_keys = hid_remove_bit(hid->release_keys, slot);
+        hid->fresh_keys = hid_remove_bit(hid->fresh_keys, slot);
+        hid_fill_slots(hid);
+    }
+}
+
+// ============================================================================
+// Public API Implementation
+// ============================================================================
+
+void snespad_hid_keyboard_init(snespad_hid_keyboard_t* hid)
+{
+    for (uint8_t i = 0; i < SNESPAD_HID_REPORT_SIZE; i++) {
+        hid->report[i] = 0;
+    }
+    for (uint8_t i = 0; i < SNESPAD_HID_KEY_SLOTS; i++) {
+        hid->keys[i] = 0;
+    }
+    for (uint8_t i = 0; i < SNESPAD_HID_PENDING; i++) {
+        hid->pending[i] = 0;
+    }
+    hid->changed = false;
+    hid->count = 0;
+    hid->pending_count = 0;
+    hid->fresh_mods = 0;
+    hid->fresh_keys = 0;
+    hid->release_mods = 0;
+    hid->release_keys = 0;
+}
+
+void snespad_hid_keyboard_key(snespad_hid_keyboard_t* hid, uint16_t key, bool down)
+{
+    uint8_t usage;
+
+    key &= 0xFF | SNESPAD_KEY_SPECIAL;
+    usage = hid_usage(key);
+    if (!usage) {
+        return;
+    }
+
+    if (down) {
+        hid_press(hid, key, usage);
+    } else {
+        hid_release(hid, key, usage);
+    }
+}
+
+void snespad_hid_keyboard_apply(snespad_hid_keyboard_t* hid, const snespad_keyboard_t* keyboard)
+{
+    for (uint8_t i = 0; i < keyboard->changes_len; i++) {
+        uint16_t change = keyboard->changes[i];
+
+        snespad_hid_keyboard_key(hid, change & ~SNESPAD_KEY_RELEASED, !(change & SNESPAD_KEY_RELEASED));
+    }
+}
+
+void snespad_hid_keyboard_event(snespad_hid_keyboard_t* hid, const snespad_event_t* event)
+{
+    switch (event->type) {
+        case SNESPAD_EVENT_KEY_DOWN:
+            snespad_hid_keyboard_key(hid, event->code, true);
+            break;
+
+        case SNESPAD_EVENT_KEY_UP:
+            snespad_hid_keyboard_key(hid, event->code, false);
+            break;
+
+        case SNESPAD_EVENT_DETACH:
+            snespad_hid_keyboard_clear(hid);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void snespad_hid_keyboard_clear(snespad_hid_keyboard_t* hid)
+{
+    bool changed = hid->changed || hid->report[0] || hid->count || hid->pending_count;
+
+    snespad_hid_keyboard_init(hid);
+    hid->changed = changed;
+}
+
+void snespad_hid_keyboard_sent(snespad_hid_keyboard_t* hid)
+{
+    uint8_t release = hid->release_keys;
+
+    hid->changed = false;
+    hid->fresh_mods = 0;
+    hid->fresh_keys = 0;
+
+    if (hid->release_mods) {
+        hid->report[0] &= ~hid->release_mods;
+        hid->release_mods = 0;
+        hid->changed = true;
+    }
+
+    // Highest slot first so lower indices stay valid
+    hid->release_keys = 0;
+    for (int8_t i = hid->count - 1; i >= 0; i--) {
+        if (release & (1 << i)) {
+            hid_remove_slot(hid, i);
+        }
+    }
+    hid_fill_slots(hid);
+}
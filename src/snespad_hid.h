@@ -0,0 +1,85 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  USB HID boot keyboard report builder. Keeps an 8-byte boot protocol
+  report (modifier bits, reserved byte, six key usage slots) up to date as
+  XBAND key changes arrive, so the USB code sends report[] whenever
+  changed is set instead of rebuilding it or calling Keyboard.h per key.
+  A key pressed and released before the report went out (XBAND letter keys
+  are taps) stays in the report until snespad_hid_keyboard_sent(), so the
+  host always sees the press.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_HID_H
+#define SNESPAD_HID_H
+
+#include "snespad_c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SNESPAD_HID_REPORT_SIZE   8
+#define SNESPAD_HID_KEY_SLOTS     6
+#define SNESPAD_HID_ROLLOVER      0x01  // ErrorRollOver usage (too many keys held)
+#define SNESPAD_HID_PENDING       8     // Held keys kept beyond the slots
+
+typedef struct {
+    // Boot report: [0] modifier bits, [1] reserved, [2..7] key usages
+    uint8_t report[SNESPAD_HID_REPORT_SIZE];
+    bool changed;               // report differs from the last one sent
+
+    uint16_t keys[SNESPAD_HID_KEY_SLOTS];  // Held keys (scancode | SNESPAD_KEY_SPECIAL), in press order
+    uint8_t count;              // Used slots
+    uint16_t pending[SNESPAD_HID_PENDING];  // Held keys that did not fit, in press order
+    uint8_t pending_count;      // Report shows rollover while non-zero
+
+    uint8_t fresh_mods;         // Modifiers pressed since the last send
+    uint8_t fresh_keys;         // Slots pressed since the last send
+    uint8_t release_mods;       // Releases held back until the next send
+    uint8_t release_keys;
+} snespad_hid_keyboard_t;
+
+// Initialize an empty report (changed is false)
+void snespad_hid_keyboard_init(snespad_hid_keyboard_t* hid);
+
+// Apply one key change
+// Parameters:
+//   key  - scancode | SNESPAD_KEY_SPECIAL (keys without a usage are ignored)
+//   down - true for press, false for release
+void snespad_hid_keyboard_key(snespad_hid_keyboard_t* hid, uint16_t key, bool down);
+
+// Apply the changes of a keyboard decoder's last poll
+void snespad_hid_keyboard_apply(snespad_hid_keyboard_t* hid, const snespad_keyboard_t* keyboard);
+
+// Apply a key event from an event queue (other event types are ignored,
+// except DETACH, which releases everything)
+void snespad_hid_keyboard_event(snespad_hid_keyboard_t* hid, const snespad_event_t* event);
+
+// Release every key
+void snespad_hid_keyboard_clear(snespad_hid_keyboard_t* hid);
+
+// Call after report[] was sent: clears changed, then applies releases that
+// were held back (which sets changed again if there were any)
+void snespad_hid_keyboard_sent(snespad_hid_keyboard_t* hid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_HID_H
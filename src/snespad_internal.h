@@ -0,0 +1,224 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Internal helpers shared by the library's translation units. Not part of
+  the public API; include snespad_c.h instead.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_INTERNAL_H
+#define SNESPAD_INTERNAL_H
+
+#include "snespad_c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ============================================================================
+// Cross-Core Access
+// ============================================================================
+// Rings and counters shared between cores or with an interrupt have one
+// writer per index. Acquire/release ordering makes a slot visible before
+// the index that publishes it (needed across RP2040 cores; single byte
+// accesses are already atomic on AVR).
+
+#define load_relaxed(p)      __atomic_load_n((p), __ATOMIC_RELAXED)
+#define store_relaxed(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define load_acquire(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define store_release(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+// ============================================================================
+// Bus Access
+// ============================================================================
+
+static inline void delay_us(snespad_t* pad, uint32_t delay_value)
+{
+    pad->bus->delay_us(pad->bus->ctx, delay_value);
+}
+
+static inline void gpio_write(snespad_t* pad, uint8_t pin, uint8_t value)
+{
+    pad->bus->write(pad->bus->ctx, pin, value);
+}
+
+static inline uint8_t gpio_read(snespad_t* pad, uint8_t pin)
+{
+    return pad->bus->read(pad->bus->ctx, pin);
+}
+
+static inline uint32_t bus_now_us(snespad_t* pad)
+{
+    return pad->bus->now_us(pad->bus->ctx);
+}
+
+// ============================================================================
+// Transfer State
+// ============================================================================
+
+// Timing profile for the device type currently connected
+static inline const snespad_timing_t* snespad_timing(const snespad_t* pad)
+{
+    return &pad->timing[pad->type + 1];
+}
+
+// Transfer phases (one bus edge or wait each, see snespad_xfer_advance)
+#define XFER_IDLE         0
+#define XFER_LATCH_HIGH   1
+#define XFER_SPEED_LOW    2
+#define XFER_SPEED_HIGH   3
+#define XFER_LATCH_LOW    4
+#define XFER_BIT_LOW      5
+#define XFER_BIT_SAMPLE   6
+#define XFER_BIT_HIGH     7
+#define XFER_KB_START     8
+#define XFER_KB_LOW       9
+#define XFER_KB_SAMPLE    10
+#define XFER_KB_HIGH      11
+#define XFER_KB_NEXT      12
+#define XFER_DONE         13
+
+// Keyboard transaction stages
+#define KB_STAGE_ID       0
+#define KB_STAGE_COUNT    1
+#define KB_STAGE_DATA     2
+
+// What a completed transfer is used for
+#define XFER_MODE_READ    0  // raw read with type detection (calibration)
+#define XFER_MODE_START   1  // device detection (snespad_start)
+#define XFER_MODE_POLL    2  // state update (snespad_poll)
+
+// Position of a speed code in the slow -> medium -> fast cycle
+// (SNES_MOUSE_SLOW 0, MEDIUM 2, FAST 1 map to 0, 1, 2)
+static inline uint8_t snespad_mouse_speed_step(uint8_t speed)
+{
+    return (2 * speed) % 3;
+}
+
+// Clock pulses during latch that take the mouse to its requested speed
+static inline uint8_t snespad_mouse_speed_pulses(const snespad_t* pad)
+{
+    if (pad->type != SNESPAD_MOUSE || pad->mouse_speed_unsupported) {
+        return 0;
+    }
+    return (3 + snespad_mouse_speed_step(pad->mouse_speed_target) -
+            snespad_mouse_speed_step(pad->mouse_speed)) % 3;
+}
+
+
+// Forget the previous poll's pressed/released buttons and key changes
+// (start of a poll)
+void snespad_clear_edges(snespad_t* pad);
+
+#if SNESPAD_STATS
+// Record a poll timestamp (snespad_poll_times_t field)
+#define STATS_TIME(pad, field)  ((pad)->stats.last.field = bus_now_us(pad))
+
+// Stamp the publish time and add a decoded poll to its type's histogram
+void snespad_stats_publish(snespad_t* pad);
+
+// Add one sample to a latency histogram
+void snespad_latency_add(snespad_latency_hist_t* hist, uint32_t latency, uint32_t bus_us);
+
+// Summarize a histogram (NULL or empty: all zero, returns false)
+bool snespad_latency_summary(const snespad_latency_hist_t* hist, snespad_latency_t* latency);
+
+// Empty a histogram
+void snespad_latency_clear(snespad_latency_hist_t* hist);
+#else
+#define STATS_TIME(pad, field)  ((void)0)
+#endif
+
+#if SNESPAD_TRACE
+// Append an entry at the trace's clock (drops it if the ring is full)
+static inline void snespad_trace_put(snespad_trace_t* trace, uint8_t lines)
+{
+    uint16_t head = trace->head;
+    snespad_trace_entry_t* e;
+
+    if ((uint16_t)(head - load_acquire(&trace->tail)) >= SNESPAD_TRACE_SIZE) {
+        trace->dropped++;
+        return;
+    }
+    e = &trace->ring[head & (SNESPAD_TRACE_SIZE - 1)];
+    e->time_us = trace->now_us;
+    e->lines = lines;
+    store_release(&trace->head, (uint16_t)(head + 1));
+}
+
+// An output line (SNESPAD_LINE_*) was driven to level
+static inline void snespad_trace_drive(snespad_trace_t* trace, uint8_t line, uint8_t level)
+{
+    trace->lines = level ? trace->lines | line : trace->lines & ~line;
+    snespad_trace_put(trace, trace->lines);
+}
+
+// Data lines in mask were sampled with the levels in data (SNESPAD_LINE_* bits)
+static inline void snespad_trace_sample(snespad_trace_t* trace, uint8_t mask, uint8_t data)
+{
+    trace->lines = (trace->lines & ~mask) | data;
+    snespad_trace_put(trace, trace->lines | SNESPAD_TRACE_SAMPLE);
+}
+
+// Transfer hooks: set the clock at the latch, advance it by each hold,
+// record drives and samples
+#define TRACE_ON(pad)                   ((pad)->trace != NULL)
+#define TRACE_SYNC(pad, time_us)        do { if ((pad)->trace) (pad)->trace->now_us = (time_us); } while (0)
+#define TRACE_WAIT(pad, us)             do { if ((pad)->trace) (pad)->trace->now_us += (us); } while (0)
+#define TRACE_DRIVE(pad, line, level)   do { if ((pad)->trace) snespad_trace_drive((pad)->trace, (line), (level)); } while (0)
+#define TRACE_SAMPLE(pad, mask, data)   do { if ((pad)->trace) snespad_trace_sample((pad)->trace, (mask), (data)); } while (0)
+#else
+#define TRACE_ON(pad)                   0
+#define TRACE_SYNC(pad, time_us)        ((void)0)
+#define TRACE_WAIT(pad, us)             ((void)0)
+#define TRACE_DRIVE(pad, line, level)   ((void)0)
+#define TRACE_SAMPLE(pad, mask, data)   ((void)0)
+#endif
+
+// A poll finished: record latency and publish the snapshot
+void snespad_poll_done(snespad_t* pad);
+
+// Reset a pad's transfer to its first phase
+void snespad_xfer_begin(snespad_t* pad, uint8_t mode);
+
+// Run type detection and the mode's post-processing on xfer.dat
+// Returns true if a poll found the device gone (type is now NONE).
+bool snespad_xfer_complete(snespad_t* pad);
+
+// Drive the next LRG rumble bit on IOBit (call before each clock low)
+void snespad_rumble_bit(snespad_t* pad);
+
+// Accumulate one keyboard dibit (data0 | data1 << 1)
+void snespad_kb_dibit(snespad_t* pad, uint8_t bits);
+
+// After a keyboard dibit's clock high: IOBit handshakes and stage changes.
+// Sets xfer.phase to XFER_KB_LOW for another dibit or XFER_DONE.
+void snespad_kb_next(snespad_t* pad);
+
+// ============================================================================
+// Packet Encoding
+// ============================================================================
+
+// Mouse axis byte for a count (sign bit, then the magnitude MSB first),
+// the inverse of snespad_decode_packet()'s axis lookup
+uint8_t snespad_mouse_axis(int8_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_INTERNAL_H
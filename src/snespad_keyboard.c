@@ -0,0 +1,109 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  XBAND keyboard decoder.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_keyboard.h"
+#include "snespad_c.h"
+
+#define PREFIX_RELEASE  1
+#define PREFIX_SPECIAL  2
+
+void snespad_keyboard_init(snespad_keyboard_t* keyboard)
+{
+    for (uint8_t i = 0; i < 16; i++) {
+        keyboard->held[i] = 0;
+    }
+    keyboard->prefix = 0;
+    keyboard->caps_locked = false;
+    keyboard->caps_led = true;
+    keyboard->changes_len = 0;
+}
+
+uint8_t snespad_keyboard_decode(snespad_keyboard_t* keyboard, const uint8_t* scancodes, uint8_t len)
+{
+    uint16_t* changes = keyboard->changes;
+    uint8_t n = 0;
+
+    if (len > SNESPAD_KEY_CHANGES_MAX / 2) {
+        len = SNESPAD_KEY_CHANGES_MAX / 2;
+    }
+
+    for (uint8_t i = 0; i < len; i++) {
+        uint8_t code = scancodes[i];
+        uint8_t prefix = (code == SNES_KEY_RELEASE) ? PREFIX_RELEASE :
+                         (code == SNES_KEY_SPECIAL) ? PREFIX_SPECIAL : 0;
+
+        // A prefix may end one poll and its key start the next
+        if (prefix) {
+            keyboard->prefix |= prefix;
+            continue;
+        }
+
+        bool up = keyboard->prefix & PREFIX_RELEASE;
+        bool special = keyboard->prefix & PREFIX_SPECIAL;
+        uint16_t key = code | (special ? SNESPAD_KEY_SPECIAL : 0);
+        uint32_t* word = &keyboard->held[key >> 5];
+        uint32_t bit = (uint32_t)1 << (key & 31);
+        bool was = (*word & bit) != 0;
+        bool releasable = snespad_key_releasable(code, special);
+
+        // Down: new presses and every make code of a tap key
+        // Up: held keys on release, tap keys right after their down
+        bool down_edge = !up && (!was || !releasable);
+        bool up_edge = up ? was : !releasable;
+
+        changes[n] = key;
+        n += down_edge;
+        changes[n] = key | SNESPAD_KEY_RELEASED;
+        n += up_edge;
+
+        // Held only between a releasable key's make and break codes
+        *word = (*word & ~bit) | (bit & (0 - (uint32_t)(!up && releasable)));
+
+        keyboard->caps_locked ^= down_edge && key == SNES_KEY_CAPS;
+        keyboard->prefix = 0;
+    }
+
+    keyboard->changes_len = n;
+    return n;
+}
+
+uint8_t snespad_keyboard_release_all(snespad_keyboard_t* keyboard)
+{
+    uint8_t n = 0;
+
+    keyboard->prefix = 0;
+
+    for (uint8_t i = 0; i < 16 && n < SNESPAD_KEY_CHANGES_MAX; i++) {
+        while (keyboard->held[i] && n < SNESPAD_KEY_CHANGES_MAX) {
+            uint32_t word = keyboard->held[i];
+            uint8_t b = 0;
+
+            while (!((word >> b) & 1)) {
+                b++;
+            }
+            keyboard->held[i] = word & (word - 1);
+            keyboard->changes[n++] = ((uint16_t)i << 5 | b) | SNESPAD_KEY_RELEASED;
+        }
+    }
+
+    keyboard->changes_len = n;
+    return n;
+}
@@ -0,0 +1,77 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  XBAND keyboard decoder. Turns the raw scancode stream of successive
+  keyboard polls into key down/up changes and a set of held keys. The
+  SNES_KEY_RELEASE/SNES_KEY_SPECIAL prefix state carries over between
+  polls, keys that never send a release scancode are reported as a tap
+  (down then up), repeated make codes of a held key are dropped, and
+  Caps Lock presses toggle a lock state for the LED.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_KEYBOARD_H
+#define SNESPAD_KEYBOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Key codes: scancode | SNESPAD_KEY_SPECIAL (same layout as key event codes)
+#define SNESPAD_KEY_SPECIAL     0x0100  // preceded by SNES_KEY_SPECIAL (0xE0)
+#define SNESPAD_KEY_RELEASED    0x8000  // change flag: key went up
+
+// Changes one decode can produce (every scancode of a poll may be a tap)
+#define SNESPAD_KEY_CHANGES_MAX 32
+
+typedef struct snespad_keyboard {
+    uint32_t held[16];          // Held keys, bit per key code (512)
+    uint8_t prefix;             // Pending SNES_KEY_RELEASE/SPECIAL prefixes
+    bool caps_locked;           // Caps Lock state, toggled on each press
+    bool caps_led;              // Drive the pad's Caps Lock LED from caps_locked
+
+    // Changes from the last decode (key code | SNESPAD_KEY_RELEASED)
+    uint16_t changes[SNESPAD_KEY_CHANGES_MAX];
+    uint8_t changes_len;
+} snespad_keyboard_t;
+
+// Initialize an empty decoder (nothing held, Caps Lock off, caps_led on)
+void snespad_keyboard_init(snespad_keyboard_t* keyboard);
+
+// Decode the scancodes of one keyboard poll (at most 16)
+// Returns: number of changes written to keyboard->changes
+uint8_t snespad_keyboard_decode(snespad_keyboard_t* keyboard, const uint8_t* scancodes, uint8_t len);
+
+// Release every held key and drop pending prefixes (keyboard unplugged)
+// Returns: number of releases written to keyboard->changes; call again
+// while it returns SNESPAD_KEY_CHANGES_MAX
+uint8_t snespad_keyboard_release_all(snespad_keyboard_t* keyboard);
+
+// true if the key (scancode | SNESPAD_KEY_SPECIAL) is held
+static inline bool snespad_keyboard_held(const snespad_keyboard_t* keyboard, uint16_t key)
+{
+    return (keyboard->held[(key >> 5) & 15] >> (key & 31)) & 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_KEYBOARD_H
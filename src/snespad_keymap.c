@@ -0,0 +1,254 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  XBAND keyboard scancode to HID keycode and usage ID tables.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_c.h"
+
+// Tables live in flash; AVR needs PROGMEM and explicit reads for that
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define KEYMAP_ROM          PROGMEM
+#define keymap_byte(p)      pgm_read_byte(p)
+#else
+#define KEYMAP_ROM
+#define keymap_byte(p)      (*(p))
+#endif
+
+// Keys are indexed by scancode | special << 8: the first page holds plain
+// scancodes, the second the ones preceded by SNES_KEY_SPECIAL
+
+// Arduino Keyboard.h style keycodes (0 = no HID key)
+static const uint8_t key_codes[512] KEYMAP_ROM = {
+    [0x01] = KEY_F1,
+    [0x02] = KEY_F2,
+    [0x03] = KEY_F3,
+    [0x04] = KEY_F4,
+    [0x05] = KEY_F5,
+    [0x06] = KEY_F6,
+    [0x07] = KEY_F7,
+    [0x08] = KEY_F8,
+    [0x09] = KEY_F9,
+    [0x0A] = KEY_F10,
+    [0x0B] = KEY_F11,
+    [0x0C] = KEY_F12,
+    [0x0D] = KEY_TAB,
+    [0x0E] = '`',
+    [0x11] = KEY_LEFT_ALT,
+    [0x12] = KEY_LEFT_SHIFT,
+    [0x14] = KEY_LEFT_CTRL,
+    [0x15] = 'q',
+    [0x16] = '1',
+    [0x1A] = 'z',
+    [0x1B] = 's',
+    [0x1C] = 'a',
+    [0x1D] = 'w',
+    [0x1E] = '2',
+    [0x21] = 'c',
+    [0x22] = 'x',
+    [0x23] = 'd',
+    [0x24] = 'e',
+    [0x25] = '4',
+    [0x26] = '3',
+    [0x29] = ' ',
+    [0x2A] = 'v',
+    [0x2B] = 'f',
+    [0x2C] = 't',
+    [0x2D] = 'r',
+    [0x2E] = '5',
+    [0x31] = 'n',
+    [0x32] = 'b',
+    [0x33] = 'h',
+    [0x34] = 'g',
+    [0x35] = 'y',
+    [0x36] = '6',
+    [0x3A] = 'm',
+    [0x3B] = 'j',
+    [0x3C] = 'u',
+    [0x3D] = '7',
+    [0x3E] = '8',
+    [0x41] = ',',
+    [0x42] = 'k',
+    [0x43] = 'i',
+    [0x44] = 'o',
+    [0x45] = '0',
+    [0x46] = '9',
+    [0x49] = '.',
+    [0x4A] = '/',
+    [0x4B] = 'l',
+    [0x4C] = ';',
+    [0x4D] = 'p',
+    [0x4E] = '-',
+    [0x52] = '\'',
+    [0x54] = '[',
+    [0x55] = '=',
+    [0x58] = KEY_CAPS_LOCK,
+    [0x59] = KEY_RIGHT_SHIFT,
+    [0x5A] = KEY_RETURN,
+    [0x5B] = ']',
+    [0x5D] = '\\',
+    [0x66] = KEY_BACKSPACE,
+    [0x69] = '1',
+    [0x6B] = '4',
+    [0x6C] = '7',
+    [0x70] = '0',
+    [0x71] = '.',
+    [0x72] = '2',
+    [0x73] = '5',
+    [0x74] = '6',
+    [0x75] = '8',
+    [0x76] = KEY_ESC,
+    [0x7A] = '3',
+    [0x7C] = '+',
+    [0x7D] = '9',
+    [0x7E] = '*',
+    [0x80] = KEY_LEFT_GUI,
+    [0x81] = KEY_RIGHT_GUI,
+
+    [0x100 | SNES_KEY_RETURN] = KEY_RETURN,
+    [0x100 | SNES_KEY_LEFT] = KEY_LEFT_ARROW,
+    [0x100 | SNES_KEY_DOWN] = KEY_DOWN_ARROW,
+    [0x100 | SNES_KEY_RIGHT] = KEY_RIGHT_ARROW,
+    [0x100 | SNES_KEY_UP] = KEY_UP_ARROW,
+};
+
+// USB HID usage IDs (keyboard/keypad page 0x07, 0 = none); modifiers use
+// their 0xE0-0xE7 usages
+static const uint8_t key_usages[512] KEYMAP_ROM = {
+    [0x01] = 0x3A,  // F1
+    [0x02] = 0x3B,  // F2
+    [0x03] = 0x3C,  // F3
+    [0x04] = 0x3D,  // F4
+    [0x05] = 0x3E,  // F5
+    [0x06] = 0x3F,  // F6
+    [0x07] = 0x40,  // F7
+    [0x08] = 0x41,  // F8
+    [0x09] = 0x42,  // F9
+    [0x0A] = 0x43,  // F10
+    [0x0B] = 0x44,  // F11
+    [0x0C] = 0x45,  // F12
+    [0x0D] = 0x2B,  // Switch (Tab)
+    [0x0E] = 0x35,  // `~
+    [0x11] = 0xE2,  // Alt
+    [0x12] = 0xE1,  // LShft
+    [0x14] = 0xE0,  // LCtl
+    [0x15] = 0x14,  // Q
+    [0x16] = 0x1E,  // 1!
+    [0x1A] = 0x1D,  // Z
+    [0x1B] = 0x16,  // S
+    [0x1C] = 0x04,  // A
+    [0x1D] = 0x1A,  // W
+    [0x1E] = 0x1F,  // 2@
+    [0x21] = 0x06,  // C
+    [0x22] = 0x1B,  // X
+    [0x23] = 0x07,  // D
+    [0x24] = 0x08,  // E
+    [0x25] = 0x21,  // 4$
+    [0x26] = 0x20,  // 3#
+    [0x29] = 0x2C,  // SPACE
+    [0x2A] = 0x19,  // V
+    [0x2B] = 0x09,  // F
+    [0x2C] = 0x17,  // T
+    [0x2D] = 0x15,  // R
+    [0x2E] = 0x22,  // 5%
+    [0x31] = 0x11,  // N
+    [0x32] = 0x05,  // B
+    [0x33] = 0x0B,  // H
+    [0x34] = 0x0A,  // G
+    [0x35] = 0x1C,  // Y
+    [0x36] = 0x23,  // 6^
+    [0x3A] = 0x10,  // M
+    [0x3B] = 0x0D,  // J
+    [0x3C] = 0x18,  // U
+    [0x3D] = 0x24,  // 7&
+    [0x3E] = 0x25,  // 8*
+    [0x41] = 0x36,  // ,<
+    [0x42] = 0x0E,  // K
+    [0x43] = 0x0C,  // I
+    [0x44] = 0x12,  // O
+    [0x45] = 0x27,  // 0)
+    [0x46] = 0x26,  // 9(
+    [0x49] = 0x37,  // .>
+    [0x4A] = 0x38,  // /?
+    [0x4B] = 0x0F,  // L
+    [0x4C] = 0x33,  // ;:
+    [0x4D] = 0x13,  // P
+    [0x4E] = 0x2D,  // -_
+    [0x52] = 0x34,  // "'
+    [0x54] = 0x2F,  // [{
+    [0x55] = 0x2E,  // =+
+    [0x58] = 0x39,  // CAPS
+    [0x59] = 0xE5,  // RShft
+    [0x5A] = 0x28,  // ENTER
+    [0x5B] = 0x30,  // ]}
+    [0x5D] = 0x31,  // Backslash
+    [0x66] = 0x2A,  // BACKSPACE
+    [0x69] = 0x59,  // NUM-1
+    [0x6B] = 0x5C,  // NUM-4
+    [0x6C] = 0x5F,  // NUM-7
+    [0x70] = 0x62,  // NUM-0
+    [0x71] = 0x63,  // NUM-.
+    [0x72] = 0x5A,  // NUM-2
+    [0x73] = 0x5D,  // NUM-5
+    [0x74] = 0x5E,  // NUM-6
+    [0x75] = 0x60,  // NUM-8
+    [0x76] = 0x29,  // ESC
+    [0x77] = 0x54,  // NUM-DIV
+    [0x79] = 0x58,  // NUM-RET
+    [0x7A] = 0x5B,  // NUM-3
+    [0x7C] = 0x57,  // NUM-ADD
+    [0x7D] = 0x61,  // NUM-9
+    [0x7E] = 0x55,  // NUM-MUL
+    [0x80] = 0xE3,  // OpenX
+    [0x81] = 0xE7,  // ClosedX
+    [0x84] = 0x56,  // NUM-SUB
+
+    [0x100 | SNES_KEY_RETURN] = 0x28,  // JOY-A (Enter)
+    [0x100 | SNES_KEY_LEFT]   = 0x50,  // Left
+    [0x100 | SNES_KEY_DOWN]   = 0x51,  // Down
+    [0x100 | SNES_KEY_RIGHT]  = 0x4F,  // Right
+    [0x100 | SNES_KEY_UP]     = 0x52,  // Up
+};
+
+// Keys that send SNES_KEY_RELEASE + scancode when let go (bit per key)
+static const uint8_t key_releasable[64] KEYMAP_ROM = {
+    [2]  = 0x16,  // 11 Alt, 12 LShft, 14 LCtl
+    [11] = 0x03,  // 58 CAPS, 59 RShft
+    [16] = 0x03,  // 80 OpenX, 81 ClosedX
+    [43] = 0x04,  // E0 5A JOY-A
+    [45] = 0x08,  // E0 6B LEFT
+    [46] = 0x34,  // E0 72 DOWN, E0 74 RIGHT, E0 75 UP
+};
+
+uint8_t snespad_key_hid(uint8_t scancode, bool special)
+{
+    return keymap_byte(&key_codes[scancode | (uint16_t)special << 8]);
+}
+
+uint8_t snespad_key_usage(uint8_t scancode, bool special)
+{
+    return keymap_byte(&key_usages[scancode | (uint16_t)special << 8]);
+}
+
+bool snespad_key_releasable(uint8_t scancode, bool special)
+{
+    uint16_t key = scancode | (uint16_t)special << 8;
+
+    return (keymap_byte(&key_releasable[key >> 3]) >> (key & 7)) & 1;
+}
@@ -0,0 +1,180 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  XBAND keyboard key names. Kept apart from the keycode table so builds
+  that never print key names do not link the strings.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_c.h"
+
+#include <stddef.h>
+
+// Plain scancodes (NULL = unused)
+static const char* const key_names[256] = {
+    [0x01] = "F1",
+    [0x02] = "F2",
+    [0x03] = "F3",
+    [0x04] = "F4",
+    [0x05] = "F5",
+    [0x06] = "F6",
+    [0x07] = "F7",
+    [0x08] = "F8",
+    [0x09] = "F9",
+    [0x0A] = "F10",
+    [0x0B] = "F11",
+    [0x0C] = "F12",
+    [0x0D] = "Switch",
+    [0x0E] = "`~",
+    [0x11] = "Alt",
+    [0x12] = "LShft",
+    [0x14] = "LCtl",
+    [0x15] = "Q",
+    [0x16] = "1!",
+    [0x1A] = "Z",
+    [0x1B] = "S",
+    [0x1C] = "A",
+    [0x1D] = "W",
+    [0x1E] = "2@",
+    [0x21] = "C",
+    [0x22] = "X",
+    [0x23] = "D",
+    [0x24] = "E",
+    [0x25] = "4$",
+    [0x26] = "3#",
+    [0x29] = "SPACE",
+    [0x2A] = "V",
+    [0x2B] = "F",
+    [0x2C] = "T",
+    [0x2D] = "R",
+    [0x2E] = "5%",
+    [0x31] = "N",
+    [0x32] = "B",
+    [0x33] = "H",
+    [0x34] = "G",
+    [0x35] = "Y",
+    [0x36] = "6^",
+    [0x3A] = "M",
+    [0x3B] = "J",
+    [0x3C] = "U",
+    [0x3D] = "7&",
+    [0x3E] = "8*",
+    [0x41] = ",<",
+    [0x42] = "K",
+    [0x43] = "I",
+    [0x44] = "O",
+    [0x45] = "0)",
+    [0x46] = "9(",
+    [0x49] = ".>",
+    [0x4A] = "/?",
+    [0x4B] = "L",
+    [0x4C] = ";:",
+    [0x4D] = "P",
+    [0x4E] = "-_",
+    [0x52] = "\"'",
+    [0x54] = "[{",
+    [0x55] = "=+",
+    [0x58] = "CAPS",
+    [0x59] = "RShft",
+    [0x5A] = "ENTER",
+    [0x5B] = "]}",
+    [0x5D] = "\\",
+    [0x66] = "BACKSPACE",
+    [0x69] = "NUM-1",
+    [0x6B] = "NUM-4",
+    [0x6C] = "NUM-7",
+    [0x70] = "NUM-0",
+    [0x71] = "NUM-.",
+    [0x72] = "NUM-2",
+    [0x73] = "NUM-5",
+    [0x74] = "NUM-6",
+    [0x75] = "NUM-8",
+    [0x76] = "ESC",
+    [0x77] = "NUM-DIV",
+    [0x79] = "NUM-RET",
+    [0x7A] = "NUM-3",
+    [0x7C] = "NUM-ADD",
+    [0x7D] = "NUM-9",
+    [0x7E] = "NUM-MUL",
+    [0x80] = "OpenX",
+    [0x81] = "ClosedX",
+    [0x84] = "NUM-SUB",
+    [0x86] = "JOY-A",
+    [0x87] = "JOY-B",
+    [0x88] = "JOY-X",
+    [0x89] = "JOY-Y",
+    [0x8A] = "JOY-L",
+    [0x8B] = "JOY-R",
+    [0x8C] = "SELECT",
+    [0x8D] = "START",
+    [0x8E] = "8Eh",
+    [0x8F] = "8Fh",
+    [0x90] = "90h",
+    [0x91] = "91h",
+    [0x92] = "92h",
+    [0x93] = "93h",
+    [0x94] = "94h",
+    [0x95] = "95h",
+    [0x96] = "96h",
+    [0x97] = "97h",
+    [0x98] = "98h",
+    [0x99] = "99h",
+    [0x9A] = "9Ah",
+    [0x9B] = "9Bh",
+    [0x9C] = "9Ch",
+    [0x9D] = "9Dh",
+};
+
+// Scancodes preceded by SNES_KEY_SPECIAL
+static const struct {
+    uint8_t scancode;
+    const char* name;
+} special_names[] = {
+    {SNES_KEY_RETURN, "JOY-A"},
+    {SNES_KEY_LEFT,   "LEFT"},
+    {SNES_KEY_DOWN,   "DOWN"},
+    {SNES_KEY_RIGHT,  "RIGHT"},
+    {SNES_KEY_UP,     "UP"},
+};
+
+const char* snespad_key_name(uint8_t scancode, bool special)
+{
+    const char* name = NULL;
+
+    if (special) {
+        for (size_t i = 0; i < sizeof(special_names) / sizeof(special_names[0]); i++) {
+            if (special_names[i].scancode == scancode) {
+                name = special_names[i].name;
+            }
+        }
+    } else {
+        name = key_names[scancode];
+    }
+
+    return name ? name : "unused";
+}
+
+snespad_key_mapping_t snespad_get_key_from_scancode(uint8_t scancode, bool special)
+{
+    snespad_key_mapping_t key;
+
+    key.key_string = snespad_key_name(scancode, special);
+    key.hid_keycode = snespad_key_hid(scancode, special);
+    key.releasable = snespad_key_releasable(scancode, special);
+
+    return key;
+}
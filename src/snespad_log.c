@@ -0,0 +1,259 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Packet record/replay log.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_log.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define LOG_RUN             0x80
+#define LOG_DISCONNECTED    0x01
+#define LOG_KEYBOARD        0x02
+#define LOG_TYPE_SHIFT      2
+#define LOG_TYPE_MASK       0x1C
+#define LOG_PACKET          0x20
+#define LOG_SCANCODES       0x40
+
+static void log_reset(snespad_log_t* log)
+{
+    memset(&log->last, 0, sizeof(log->last));
+    log->last.type = -1;
+    log->records = 0;
+    log->run = 0;
+    log->run_step = 0;
+}
+
+static uint8_t log_put_varint(uint8_t* out, uint32_t value)
+{
+    uint8_t n = 0;
+
+    while (value >= 0x80) {
+        out[n++] = (value & 0x7F) | 0x80;
+        value >>= 7;
+    }
+    out[n++] = value;
+    return n;
+}
+
+static bool log_get_varint(snespad_log_t* log, uint32_t* value)
+{
+    uint32_t v = 0;
+
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        uint8_t b;
+
+        if (log->pos >= log->data_len) {
+            return false;
+        }
+        b = log->data[log->pos++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *value = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Write one whole entry, or none of it
+static void log_emit(snespad_log_t* log, const uint8_t* entry, uint32_t len)
+{
+    if (log->write) {
+        log->write(log->ctx, entry, len);
+    } else if (!log->overflow && log->len + len <= log->size) {
+        memcpy(log->buf + log->len, entry, len);
+        log->len += len;
+    } else {
+        log->overflow = true;
+    }
+}
+
+static void log_emit_run(snespad_log_t* log)
+{
+    uint8_t entry[6];
+
+    entry[0] = LOG_RUN | (log->run - 1);
+    log_emit(log, entry, 1 + log_put_varint(entry + 1, log->run_step));
+    log->run = 0;
+}
+
+// Header bits that describe the record itself
+static uint8_t log_flags(const snespad_log_record_t* r)
+{
+    return (r->disconnected ? LOG_DISCONNECTED : 0) |
+           (r->keyboard ? LOG_KEYBOARD : 0) |
+           (((uint8_t)(r->type + 1) << LOG_TYPE_SHIFT) & LOG_TYPE_MASK);
+}
+
+// Header of a record relative to the previous one
+static uint8_t log_header(const snespad_log_t* log, const snespad_log_record_t* r)
+{
+    uint8_t h = log_flags(r);
+
+    if (r->packet != log->last.packet) {
+        h |= LOG_PACKET;
+    }
+    if (r->scancodes_len != log->last.scancodes_len || (r->keyboard && r->scancodes_len)) {
+        h |= LOG_SCANCODES;
+    }
+    return h;
+}
+
+void snespad_log_init(snespad_log_t* log, uint8_t* buf, uint32_t size)
+{
+    log->buf = buf;
+    log->size = size;
+    log->len = 0;
+    log->write = NULL;
+    log->ctx = NULL;
+    log->overflow = false;
+    log->data = NULL;
+    log->data_len = 0;
+    log->pos = 0;
+    log_reset(log);
+}
+
+void snespad_log_init_stream(snespad_log_t* log, snespad_log_write_fn write, void* ctx)
+{
+    snespad_log_init(log, NULL, 0);
+    log->write = write;
+    log->ctx = ctx;
+}
+
+void snespad_log_write(snespad_log_t* log, const snespad_log_record_t* record)
+{
+    uint8_t entry[SNESPAD_LOG_ENTRY_MAX];
+    uint32_t step = record->time_us - log->last.time_us;
+    uint8_t len = record->scancodes_len > 16 ? 16 : record->scancodes_len;
+    uint8_t h = log_header(log, record);
+    uint32_t n = 0;
+
+    // Same as the previous record, nothing to send but the time
+    if (log->records && h == log_flags(&log->last)) {
+        if (log->run && (step != log->run_step || log->run == SNESPAD_LOG_RUN_MAX)) {
+            log_emit_run(log);
+        }
+        if (!log->run) {
+            log->run_step = step;
+        }
+        log->run++;
+        log->last.time_us = record->time_us;
+        log->records++;
+        return;
+    }
+
+    if (log->run) {
+        log_emit_run(log);
+    }
+
+    entry[n++] = h;
+    n += log_put_varint(entry + n, step);
+    if (h & LOG_PACKET) {
+        n += log_put_varint(entry + n, record->packet ^ log->last.packet);
+    }
+    if (h & LOG_SCANCODES) {
+        entry[n++] = len;
+        if (record->keyboard) {
+            memcpy(entry + n, record->scancodes, len);
+            n += len;
+        }
+    }
+    log_emit(log, entry, n);
+
+    log->last = *record;
+    log->last.scancodes_len = len;
+    log->records++;
+}
+
+void snespad_log_flush(snespad_log_t* log)
+{
+    if (log->run) {
+        log_emit_run(log);
+    }
+}
+
+void snespad_log_open(snespad_log_t* log, const uint8_t* data, uint32_t len)
+{
+    snespad_log_init(log, NULL, 0);
+    log->data = data;
+    log->data_len = len;
+}
+
+bool snespad_log_read(snespad_log_t* log, snespad_log_record_t* record)
+{
+    snespad_log_record_t* last = &log->last;
+    uint32_t value;
+    uint8_t h;
+
+    if (!log->run) {
+        if (log->pos >= log->data_len) {
+            return false;
+        }
+        h = log->data[log->pos++];
+
+        if (h & LOG_RUN) {
+            if (!log->records || !log_get_varint(log, &log->run_step)) {
+                return false;
+            }
+            log->run = (h & ~LOG_RUN) + 1;
+        } else {
+            if (!log_get_varint(log, &value)) {
+                return false;
+            }
+            last->time_us += value;
+            last->disconnected = (h & LOG_DISCONNECTED) != 0;
+            last->keyboard = (h & LOG_KEYBOARD) != 0;
+            last->type = (int8_t)((h & LOG_TYPE_MASK) >> LOG_TYPE_SHIFT) - 1;
+
+            if (h & LOG_PACKET) {
+                if (!log_get_varint(log, &value)) {
+                    return false;
+                }
+                last->packet ^= value;
+            }
+
+            // Scancodes are only read from keyboards, otherwise they stay zero
+            memset(last->scancodes, 0, sizeof(last->scancodes));
+            if (h & LOG_SCANCODES) {
+                if (log->pos >= log->data_len || log->data[log->pos] > 16) {
+                    return false;
+                }
+                last->scancodes_len = log->data[log->pos++];
+                if (last->keyboard) {
+                    if (log->data_len - log->pos < last->scancodes_len) {
+                        return false;
+                    }
+                    memcpy(last->scancodes, log->data + log->pos, last->scancodes_len);
+                    log->pos += last->scancodes_len;
+                }
+            }
+        }
+    }
+
+    if (log->run) {
+        log->run--;
+        last->time_us += log->run_step;
+    }
+
+    *record = *last;
+    log->records++;
+    return true;
+}
@@ -0,0 +1,109 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Packet record/replay log. A pad with a record log appends every completed
+  transfer (raw line levels, detected type, keyboard scancodes and latch
+  time) to a compact binary log; a pad with a replay log takes its
+  transfers from such a log instead of the bus, so snespad_poll() decodes
+  exactly the recorded input. Used to reproduce field bugs on the host and
+  to run the decode path without bus timing.
+
+  Encoding: each entry starts with a header byte.
+    1nnnnnnn             n + 1 repeats of the previous record, then the
+                         time step between them (varint)
+    0SPtttkd             one record: d = disconnected, k = keyboard,
+                         ttt = type + 1, then the time since the previous
+                         record (varint); P: packet XOR previous packet
+                         (varint); S: scancode count byte, followed by the
+                         scancodes if k is set
+  Idle polls repeat at a fixed period, so they collapse into runs; changed
+  packets usually differ in a few low bits and stay short.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_LOG_H
+#define SNESPAD_LOG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SNESPAD_LOG_RUN_MAX     128  // repeats per run entry
+#define SNESPAD_LOG_ENTRY_MAX   28   // largest single record entry in bytes
+
+// One completed transfer
+typedef struct {
+    uint32_t time_us;           // Latch time
+    uint32_t packet;            // Raw line levels as clocked in (active low)
+    int8_t type;                // Device type detected from it
+    bool disconnected;          // Data line was high before latch
+    bool keyboard;              // XBAND keyboard id was read
+    uint8_t scancodes_len;
+    uint8_t scancodes[16];
+} snespad_log_record_t;
+
+// Stream sink: receives whole entries
+typedef void (*snespad_log_write_fn)(void* ctx, const uint8_t* data, uint32_t len);
+
+typedef struct snespad_log {
+    // Writer: either a buffer or a stream sink
+    uint8_t* buf;
+    uint32_t size;
+    uint32_t len;               // Bytes written to buf
+    snespad_log_write_fn write;
+    void* ctx;
+    bool overflow;              // buf filled up; later records were dropped
+
+    // Reader
+    const uint8_t* data;
+    uint32_t data_len;
+    uint32_t pos;
+
+    // Delta state shared by both directions
+    snespad_log_record_t last;
+    uint32_t records;           // Records written or read
+    uint8_t run;                // Writer: repeats not emitted yet; reader: repeats left
+    uint32_t run_step;          // Time step of the current run
+} snespad_log_t;
+
+// Record into a caller buffer (stops at the first record that does not fit)
+void snespad_log_init(snespad_log_t* log, uint8_t* buf, uint32_t size);
+
+// Record into a stream (file, UART, ...)
+void snespad_log_init_stream(snespad_log_t* log, snespad_log_write_fn write, void* ctx);
+
+// Append a record
+void snespad_log_write(snespad_log_t* log, const snespad_log_record_t* record);
+
+// Emit a pending run; call before using the recorded bytes
+void snespad_log_flush(snespad_log_t* log);
+
+// Replay from recorded bytes
+void snespad_log_open(snespad_log_t* log, const uint8_t* data, uint32_t len);
+
+// Next record of a replay log
+// Returns: false at the end of the log (or on a truncated entry)
+bool snespad_log_read(snespad_log_t* log, snespad_log_record_t* record);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_LOG_H
@@ -0,0 +1,110 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Mouse motion accumulator.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_motion.h"
+
+#include <stddef.h>
+
+// 8.8 amount for one axis: count * curve gain * sensitivity. The gain
+// product is at most 2^24, so 127 counts still fit in 31 bits.
+static int32_t motion_scale(const snespad_motion_t* motion, int8_t count)
+{
+    uint8_t mag = count < 0 ? -count : count;
+    uint32_t gain = motion->sensitivity;
+
+    if (motion->curve) {
+        gain = (gain * motion->curve[mag & (SNESPAD_MOTION_CURVE_LEN - 1)]) >> 8;
+    }
+
+    return (int32_t)count * (int32_t)gain;
+}
+
+// Whole counts available on one axis, clamped to +/-limit
+static int16_t motion_take_axis(uint32_t total, uint32_t* taken, int16_t limit)
+{
+    int32_t pending = (int32_t)(total - *taken);
+    int32_t whole = pending / SNESPAD_MOTION_ONE;  // toward zero, remainder kept
+
+    if (whole > limit) {
+        whole = limit;
+    } else if (whole < -limit) {
+        whole = -limit;
+    }
+
+    __atomic_store_n(taken, *taken + (uint32_t)whole * SNESPAD_MOTION_ONE, __ATOMIC_RELAXED);
+    return (int16_t)whole;
+}
+
+void snespad_motion_init(snespad_motion_t* motion)
+{
+    motion->total_x = 0;
+    motion->total_y = 0;
+    motion->taken_x = 0;
+    motion->taken_y = 0;
+    motion->sensitivity = SNESPAD_MOTION_ONE;
+    motion->curve = NULL;
+}
+
+void snespad_motion_set_sensitivity(snespad_motion_t* motion, uint16_t sensitivity)
+{
+    motion->sensitivity = sensitivity;
+}
+
+void snespad_motion_set_curve(snespad_motion_t* motion, const uint16_t* curve)
+{
+    motion->curve = curve;
+}
+
+void snespad_motion_curve(uint16_t* curve, uint8_t threshold, uint16_t accel)
+{
+    for (uint8_t i = 0; i < SNESPAD_MOTION_CURVE_LEN; i++) {
+        uint32_t gain = SNESPAD_MOTION_ONE;
+
+        if (i > threshold) {
+            gain += (uint32_t)accel * (i - threshold);
+        }
+        curve[i] = gain > 0xFFFF ? 0xFFFF : gain;
+    }
+}
+
+void snespad_motion_add(snespad_motion_t* motion, int8_t dx, int8_t dy)
+{
+    // Release: a consumer that sees the new total also sees the earlier ones
+    __atomic_store_n(&motion->total_x, motion->total_x + (uint32_t)motion_scale(motion, dx), __ATOMIC_RELEASE);
+    __atomic_store_n(&motion->total_y, motion->total_y + (uint32_t)motion_scale(motion, dy), __ATOMIC_RELEASE);
+}
+
+bool snespad_motion_take(snespad_motion_t* motion, int16_t* dx, int16_t* dy, int16_t limit)
+{
+    uint32_t total_x = __atomic_load_n(&motion->total_x, __ATOMIC_ACQUIRE);
+    uint32_t total_y = __atomic_load_n(&motion->total_y, __ATOMIC_ACQUIRE);
+
+    *dx = motion_take_axis(total_x, &motion->taken_x, limit);
+    *dy = motion_take_axis(total_y, &motion->taken_y, limit);
+
+    return *dx || *dy;
+}
+
+void snespad_motion_clear(snespad_motion_t* motion)
+{
+    __atomic_store_n(&motion->taken_x, __atomic_load_n(&motion->total_x, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+    __atomic_store_n(&motion->taken_y, __atomic_load_n(&motion->total_y, __ATOMIC_ACQUIRE), __ATOMIC_RELAXED);
+}
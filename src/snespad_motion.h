@@ -0,0 +1,84 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Mouse motion accumulator. The SNES mouse clears its motion counters on
+  every latch, so mouse_x/mouse_y only show the motion of the last poll.
+  An accumulator sums the signed counts of every poll (after an optional
+  sensitivity and acceleration curve, in 8.8 fixed point) until the
+  consumer takes them, so the mouse can be polled faster than reports are
+  sent without losing motion. Motion beyond what one report can carry and
+  sub-count fractions stay in the accumulator for the next take.
+
+  The poller only writes the running totals and the consumer only writes
+  what it has taken, so the two may run on different cores or in an ISR
+  and the main loop without locks.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_MOTION_H
+#define SNESPAD_MOTION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SNESPAD_MOTION_ONE        256  // 1.0 in 8.8 fixed point
+#define SNESPAD_MOTION_CURVE_LEN  128  // curve entries, one per count magnitude
+
+typedef struct snespad_motion {
+    uint32_t total_x;           // Producer: 8.8 running sums (wrap freely)
+    uint32_t total_y;
+    uint32_t taken_x;           // Consumer: 8.8 amounts already taken
+    uint32_t taken_y;
+
+    uint16_t sensitivity;       // 8.8 gain (SNESPAD_MOTION_ONE = 1.0)
+    const uint16_t* curve;      // 8.8 gain per count magnitude 0-127, NULL = flat
+} snespad_motion_t;
+
+// Initialize an empty accumulator (sensitivity 1.0, no curve)
+void snespad_motion_init(snespad_motion_t* motion);
+
+// Set the overall gain (8.8 fixed point, e.g. 384 = 1.5)
+void snespad_motion_set_sensitivity(snespad_motion_t* motion, uint16_t sensitivity);
+
+// Set an acceleration curve: gain applied to a poll's count by its
+// magnitude (SNESPAD_MOTION_CURVE_LEN entries, kept by the caller; NULL = flat)
+void snespad_motion_set_curve(snespad_motion_t* motion, const uint16_t* curve);
+
+// Fill a curve that is flat (1.0) up to threshold counts per poll and then
+// rises by accel (8.8) per count
+void snespad_motion_curve(uint16_t* curve, uint8_t threshold, uint16_t accel);
+
+// Producer: add one poll's signed counts (-127..127)
+void snespad_motion_add(snespad_motion_t* motion, int8_t dx, int8_t dy);
+
+// Consumer: take the whole counts accumulated so far, each clamped to
+// +/-limit (127 for boot protocol mice, 32767 for 16-bit reports)
+// Returns: true if any motion was taken
+bool snespad_motion_take(snespad_motion_t* motion, int16_t* dx, int16_t* dy, int16_t limit);
+
+// Consumer: drop everything not taken yet
+void snespad_motion_clear(snespad_motion_t* motion);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_MOTION_H
@@ -0,0 +1,180 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Passthrough pipeline: physical pad to console.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_passthrough.h"
+#include "snespad_internal.h"
+
+// Fold a console latch into the period estimate and record the age of the
+// sample it read
+static void passthrough_latch(snespad_passthrough_t* pt, uint32_t latches, uint32_t latch_us)
+{
+    if (pt->latch_seen) {
+        uint32_t interval = (latch_us - pt->latch_us) / (latches - pt->latches);
+
+        if (!pt->period_us || pt->outliers >= SNESPAD_PASSTHROUGH_RELEARN) {
+            // First period, or the console changed its frame rate
+            pt->period_us = interval;
+            pt->outliers = 0;
+        } else if (interval + pt->period_us / 8 >= pt->period_us &&
+                   interval <= pt->period_us + pt->period_us / 8) {
+            pt->period_us += ((int32_t)(interval - pt->period_us)) / 8;
+            pt->outliers = 0;
+        } else {
+            pt->outliers++;  // lag frame, reset, reads outside vblank
+        }
+    }
+    pt->latch_seen = true;
+    pt->latches = latches;
+    pt->latch_us = latch_us;
+
+    if (pt->sampled) {
+        uint32_t age = latch_us - pt->sample_us;
+
+        pt->last_age_us = age;
+        if (age > pt->max_age_us) pt->max_age_us = age;
+        if (!pt->fresh) pt->stale++;
+        pt->fresh = false;
+#if SNESPAD_STATS
+        snespad_latency_add(&pt->hist, age, pt->poll_us);
+#endif
+    }
+
+    // Next poll finishes margin_us before the predicted latch (right away
+    // while the period is still unknown)
+    snespad_sched_set_deadline(&pt->sched, latch_us + pt->period_us);
+}
+
+// ============================================================================
+// Public API Implementation
+// ============================================================================
+
+void snespad_passthrough_init(snespad_passthrough_t* pt, snespad_t* pad,
+                              snespad_device_t* device, uint32_t margin_us)
+{
+    pt->pad = pad;
+    pt->device = device;
+    snespad_sched_init(&pt->sched, pad, margin_us);
+
+    for (uint8_t i = 0; i < 12; i++) {
+        pt->remap[i] = 1 << i;
+    }
+    pt->turbo = 0;
+    pt->turbo_latches = 0;
+
+    pt->latch_seen = false;
+    pt->latches = device->latches;
+    pt->latch_us = 0;
+    pt->period_us = 0;
+    pt->outliers = 0;
+
+    pt->sampled = false;
+    pt->fresh = false;
+    pt->sample_us = 0;
+    pt->poll_us = 0;
+    pt->last_age_us = 0;
+    pt->max_age_us = 0;
+    pt->stale = 0;
+#if SNESPAD_STATS
+    snespad_latency_clear(&pt->hist);
+#endif
+
+    // Serve something before the first latch
+    snespad_sched_set_deadline(&pt->sched, bus_now_us(pad));
+}
+
+void snespad_passthrough_remap(snespad_passthrough_t* pt, uint16_t button, uint16_t output)
+{
+    for (uint8_t i = 0; i < 12; i++) {
+        if (button & (1 << i)) {
+            pt->remap[i] = output & SNES_BUTTONS;
+        }
+    }
+}
+
+void snespad_passthrough_set_turbo(snespad_passthrough_t* pt, uint16_t buttons, uint8_t latches)
+{
+    pt->turbo = latches ? buttons & SNES_BUTTONS : 0;
+    pt->turbo_latches = latches;
+}
+
+uint16_t snespad_passthrough_map(const snespad_passthrough_t* pt, uint16_t buttons, uint32_t latch)
+{
+    uint16_t out = 0;
+
+    for (uint8_t i = 0; buttons; i++, buttons >>= 1) {
+        if (buttons & 1) {
+            out |= pt->remap[i];
+        }
+    }
+
+    // Released during the off phase of the cycle
+    if (pt->turbo && ((latch / pt->turbo_latches) & 1)) {
+        out &= ~pt->turbo;
+    }
+    return out;
+}
+
+bool snespad_passthrough_run(snespad_passthrough_t* pt)
+{
+    snespad_device_t* dev = pt->device;
+    uint32_t latches, latch_us;
+    int16_t dx, dy;
+
+    // The latch interrupt may update both while they are read
+    do {
+        latches = dev->latches;
+        latch_us = dev->latch_us;
+    } while (latches != dev->latches);
+
+    if (latches != pt->latches) {
+        passthrough_latch(pt, latches, latch_us);
+    }
+
+    if (!snespad_sched_run(&pt->sched)) {
+        return false;
+    }
+
+    // Buttons go out with the next latch
+    snespad_device_set_buttons(dev, snespad_passthrough_map(pt, pt->pad->buttons & SNES_BUTTONS,
+                                                            latches + 1));
+    if (pt->pad->motion && snespad_motion_take(pt->pad->motion, &dx, &dy, 32767)) {
+        snespad_device_mouse_move(dev, dx, dy);
+    }
+
+    pt->sampled = true;
+    pt->fresh = true;
+    pt->sample_us = pt->sched.last_start_us;
+    pt->poll_us = bus_now_us(pt->pad) - pt->sample_us;
+    return true;
+}
+
+#if SNESPAD_STATS
+bool snespad_passthrough_get_latency(const snespad_passthrough_t* pt, snespad_latency_t* latency)
+{
+    return snespad_latency_summary(&pt->hist, latency);
+}
+
+void snespad_passthrough_reset_latency(snespad_passthrough_t* pt)
+{
+    snespad_latency_clear(&pt->hist);
+    pt->max_age_us = 0;
+}
+#endif
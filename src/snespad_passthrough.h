@@ -0,0 +1,113 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Passthrough pipeline: poll a physical pad, remap and turbo its buttons,
+  and answer a console with the result in device mode (snespad_device.h).
+  The console latches once per frame, so the pipeline measures the latch
+  period from the device's latch timestamps and uses the just-in-time
+  scheduler (snespad_sched.h) to run the physical poll margin_us before the
+  next predicted latch. The sample the console reads is then only the poll
+  time plus the margin old, instead of anything up to a whole frame.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_PASSTHROUGH_H
+#define SNESPAD_PASSTHROUGH_H
+
+#include "snespad_c.h"
+#include "snespad_device.h"
+#include "snespad_sched.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SNESPAD_PASSTHROUGH_RELEARN  4  // off-period latches in a row before relearning
+
+typedef struct {
+    snespad_t* pad;             // Physical controller
+    snespad_device_t* device;   // Console side (begun by the caller)
+    snespad_sched_t sched;      // Runs the poll before the predicted latch
+
+    // Remap and turbo
+    uint16_t remap[12];         // Output buttons for each input button bit
+    uint16_t turbo;             // Output buttons that auto-fire while held
+    uint8_t turbo_latches;      // Latches per turbo on and off phase
+
+    // Console latch tracking
+    bool latch_seen;
+    uint32_t latches;           // device->latches last handled
+    uint32_t latch_us;          // Time of that latch
+    uint32_t period_us;         // Smoothed latch period (0 = not measured yet)
+    uint8_t outliers;           // Latch intervals in a row far from period_us
+
+    // Results
+    bool sampled;               // The device holds a polled sample
+    bool fresh;                 // Polled since the last latch
+    uint32_t sample_us;         // When the poll that produced it started
+    uint32_t poll_us;           // How long that poll took
+    uint32_t last_age_us;       // Sample age at the last console latch
+    uint32_t max_age_us;        // Largest age since init
+    uint32_t stale;             // Latches that got the previous frame's sample
+
+#if SNESPAD_STATS
+    snespad_latency_hist_t hist;  // Sample age at the console latch
+#endif
+} snespad_passthrough_t;
+
+// Initialize a pipeline between a pad (after snespad_init / snespad_set_bus
+// / snespad_begin) and a device (after snespad_device_begin). Buttons pass
+// through unchanged until remapped.
+// Parameters:
+//   pt        - Pipeline state
+//   pad       - Physical controller to poll
+//   device    - Device answering the console
+//   margin_us - Time to leave between the end of the poll and the latch;
+//               must cover the time between two snespad_passthrough_run calls
+void snespad_passthrough_init(snespad_passthrough_t* pt, snespad_t* pad,
+                              snespad_device_t* device, uint32_t margin_us);
+
+// Send output instead of button (a SNES_* mask; output may hold several
+// buttons or be 0 to drop it)
+void snespad_passthrough_remap(snespad_passthrough_t* pt, uint16_t button, uint16_t output);
+
+// Auto-fire the given output buttons while held, alternating every
+// latches console latches (0 or no buttons = off)
+void snespad_passthrough_set_turbo(snespad_passthrough_t* pt, uint16_t buttons, uint8_t latches);
+
+// Output buttons for an input state at a latch count (remap, then turbo)
+uint16_t snespad_passthrough_map(const snespad_passthrough_t* pt, uint16_t buttons, uint32_t latch);
+
+// Call often from the main loop. Tracks the console's latches and polls
+// the pad once per frame, just before the next predicted latch.
+// Returns: true if a new sample was handed to the device
+bool snespad_passthrough_run(snespad_passthrough_t* pt);
+
+#if SNESPAD_STATS
+// Age of the sample the console latched (poll start to console latch)
+// Returns: false if no latch has been answered with a sample yet
+bool snespad_passthrough_get_latency(const snespad_passthrough_t* pt, snespad_latency_t* latency);
+
+// Clear the age histogram and max_age_us
+void snespad_passthrough_reset_latency(snespad_passthrough_t* pt);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_PASSTHROUGH_H
@@ -0,0 +1,135 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Just-in-time poll scheduler.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_sched.h"
+#include "snespad_internal.h"
+
+// Upper bound for a poll before it has been measured: latch, 32 bits,
+// the mouse gap and the keyboard id/count dibits
+static uint32_t sched_estimate(const snespad_t* pad, int8_t type)
+{
+    const snespad_timing_t* t = &pad->timing[type + 1];
+
+    return 2 * t->latch_us + 38 * (uint32_t)(t->clock_low_us + t->clock_high_us) + t->clock_high_us;
+}
+
+// Fold a measured poll time into the type's cost
+static void sched_learn(snespad_sched_t* sched, int8_t type, uint32_t cost_us)
+{
+    uint32_t* avg = &sched->cost_avg_us[type + 1];
+    uint32_t* peak = &sched->cost_peak_us[type + 1];
+    uint8_t bit = 1 << (type + 1);
+
+    // First measurement replaces the estimate
+    if (!(sched->measured & bit)) {
+        sched->measured |= bit;
+        *avg = cost_us;
+        *peak = cost_us;
+        return;
+    }
+
+    *avg = *avg - *avg / 8 + cost_us / 8;
+
+    // Peak follows increases at once and decays slowly toward the average
+    if (cost_us >= *peak) {
+        *peak = cost_us;
+    } else if (*peak > *avg) {
+        *peak -= (*peak - *avg) / 16;
+    }
+}
+
+void snespad_sched_init(snespad_sched_t* sched, snespad_t* pad, uint32_t margin_us)
+{
+    sched->pad = pad;
+    sched->margin_us = margin_us;
+    sched->period_us = 0;
+    sched->deadline_us = 0;
+    sched->polled = true;  // nothing to do until a deadline is set
+    sched->measured = 0;
+
+    for (int8_t type = SNESPAD_NONE; type <= SNESPAD_KEYBOARD; type++) {
+        sched->cost_avg_us[type + 1] = sched_estimate(pad, type);
+        sched->cost_peak_us[type + 1] = sched->cost_avg_us[type + 1];
+    }
+
+    sched->last_start_us = 0;
+    sched->last_age_us = 0;
+    sched->polls = 0;
+    sched->late = 0;
+}
+
+void snespad_sched_set_deadline(snespad_sched_t* sched, uint32_t deadline_us)
+{
+    sched->deadline_us = deadline_us;
+    sched->polled = false;
+}
+
+void snespad_sched_set_period(snespad_sched_t* sched, uint32_t period_us)
+{
+    sched->period_us = period_us;
+}
+
+uint32_t snespad_sched_start_time(const snespad_sched_t* sched)
+{
+    const snespad_t* pad = sched->pad;
+
+    return sched->deadline_us - sched->margin_us - sched->cost_peak_us[pad->type + 1];
+}
+
+bool snespad_sched_run(snespad_sched_t* sched)
+{
+    snespad_t* pad = sched->pad;
+    int8_t type = pad->type;
+    uint32_t start, end;
+
+    if (sched->polled) {
+        return false;
+    }
+
+    start = bus_now_us(pad);
+    if ((int32_t)(start - snespad_sched_start_time(sched)) < 0) {
+        return false;  // too early, state would go stale before the report
+    }
+
+    snespad_poll(pad);
+    end = bus_now_us(pad);
+
+    // The cost belongs to the profile the poll ran with
+    sched_learn(sched, type, end - start);
+
+    sched->last_start_us = start;
+    sched->last_age_us = sched->deadline_us - start;
+    sched->polls++;
+    if ((int32_t)(end - sched->deadline_us) > 0) {
+        sched->late++;
+    }
+
+    if (sched->period_us) {
+        // Next deadline, skipping any that were missed entirely
+        do {
+            sched->deadline_us += sched->period_us;
+        } while ((int32_t)(end - sched->deadline_us) >= 0);
+    } else {
+        sched->polled = true;
+    }
+
+    return true;
+}
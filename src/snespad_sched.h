@@ -0,0 +1,80 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Just-in-time poll scheduler. Given the consumer's next report deadline
+  (a USB SOF, a 1 ms tick, ...) it starts the bus transfer just late
+  enough to finish right before the deadline, using the transfer cost it
+  has measured for the connected device type, so the state that goes out
+  in the report is as fresh as possible.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_SCHED_H
+#define SNESPAD_SCHED_H
+
+#include "snespad_c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    snespad_t* pad;
+
+    // Learned poll cost per device type (indexed by type + 1)
+    uint32_t cost_avg_us[5];    // Moving average
+    uint32_t cost_peak_us[5];   // Slowly decaying maximum (used for scheduling)
+    uint8_t measured;           // Bit type + 1 set once that type was timed
+
+    uint32_t margin_us;         // Guard time left before the deadline
+    uint32_t period_us;         // Deadline spacing (0 = set each deadline by hand)
+    uint32_t deadline_us;       // Next report deadline (bus clock)
+    bool polled;                // Already polled for this deadline
+
+    // Results
+    uint32_t last_start_us;     // When the last scheduled poll started
+    uint32_t last_age_us;       // Its sample age at the deadline
+    uint32_t polls;             // Scheduled polls run
+    uint32_t late;              // Polls that finished after their deadline
+} snespad_sched_t;
+
+// Initialize a scheduler for a pad (after snespad_init / snespad_set_bus)
+// Parameters:
+//   sched     - Scheduler state
+//   pad       - Pad to poll
+//   margin_us - Time to leave between the end of the poll and the deadline
+void snespad_sched_init(snespad_sched_t* sched, snespad_t* pad, uint32_t margin_us);
+
+// Set the next report deadline (bus clock time, e.g. now + 1000 at SOF)
+void snespad_sched_set_deadline(snespad_sched_t* sched, uint32_t deadline_us);
+
+// Repeat deadlines every period_us after the current one (0 = off)
+void snespad_sched_set_period(snespad_sched_t* sched, uint32_t period_us);
+
+// Bus clock time at which the poll for the current deadline will start
+uint32_t snespad_sched_start_time(const snespad_sched_t* sched);
+
+// Call often from the main loop. Polls once per deadline when its start
+// time arrives and learns how long the poll took.
+// Returns: true if a poll ran (fresh state for the upcoming report)
+bool snespad_sched_run(snespad_sched_t* sched);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_SCHED_H
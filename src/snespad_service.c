@@ -0,0 +1,304 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Background polling service.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_service.h"
+#include "snespad_internal.h"
+
+#include <stddef.h>
+
+#if defined(SNESPAD_HOST)
+#define SERVICE_THREAD 1
+#elif !defined(ARDUINO) || defined(ARDUINO_ARCH_RP2040)
+#include "pico/multicore.h"
+#define SERVICE_PICO 1
+#endif
+
+static snespad_t* service_lead(const snespad_service_t* service)
+{
+    return service->group ? service->group->port[0] : service->pads[0];
+}
+
+static void service_poll(snespad_service_t* service)
+{
+    if (service->group) {
+        snespad_group_poll(service->group);
+        return;
+    }
+
+    for (uint8_t i = 0; i < service->count; i++) {
+        snespad_poll(service->pads[i]);
+    }
+}
+
+// A round starts at now: record how late it is
+static void service_round_begin(snespad_service_t* service, uint32_t now)
+{
+    uint32_t late = now - service->next_us;
+
+    if (late > service->health.max_late_us) {
+        store_relaxed(&service->health.max_late_us, late);
+    }
+    service->round_us = now;
+}
+
+// The round ended at end: update health and schedule the next one
+// Returns: microseconds until the next round is due
+static uint32_t service_round_end(snespad_service_t* service, uint32_t end)
+{
+    snespad_service_health_t* health = &service->health;
+    uint32_t period = load_relaxed(&service->period_us);
+    uint32_t late = service->round_us - service->next_us;
+    uint32_t took = end - service->round_us;
+
+    store_relaxed(&health->last_poll_us, took);
+    if (took > health->max_poll_us) {
+        store_relaxed(&health->max_poll_us, took);
+    }
+    store_relaxed(&health->loops, health->loops + 1);
+
+    // Keep the rate; a round that fell a whole period behind restarts it.
+    // Period 0 runs as fast as possible, so it is never an overrun.
+    if (late >= period) {
+        if (period) {
+            store_relaxed(&health->overruns, health->overruns + 1);
+        }
+        service->next_us = service->round_us + period;
+    } else {
+        service->next_us += period;
+    }
+
+    return (int32_t)(service->next_us - end) > 0 ? service->next_us - end : 0;
+}
+
+uint32_t snespad_service_tick(snespad_service_t* service)
+{
+    snespad_t* lead = service_lead(service);
+    uint32_t now = bus_now_us(lead);
+
+    if ((int32_t)(now - service->next_us) < 0) {
+        return service->next_us - now;
+    }
+
+    service_round_begin(service, now);
+    service_poll(service);
+    return service_round_end(service, bus_now_us(lead));
+}
+
+uint32_t snespad_service_step(snespad_service_t* service)
+{
+    uint32_t now = bus_now_us(service->pads[0]);
+
+    if (!service->stepping) {
+        if ((int32_t)(now - service->next_us) < 0) {
+            return service->next_us - now;
+        }
+        service_round_begin(service, now);
+        service->index = 0;
+        service->stepping = true;
+    }
+
+    // Pads are read one after another, one bus phase per call
+    while (service->index < service->count) {
+        snespad_t* pad = service->pads[service->index];
+
+        if (!snespad_poll_step(pad)) {
+            uint32_t deadline = snespad_poll_deadline(pad);
+
+            now = bus_now_us(pad);
+            return (int32_t)(deadline - now) > 0 ? deadline - now : 0;
+        }
+        service->index++;
+    }
+
+    service->stepping = false;
+    return service_round_end(service, bus_now_us(service->pads[0]));
+}
+
+// Dedicated loop (core1 or host thread; the host runs timer mode here too)
+static void service_loop(snespad_service_t* service)
+{
+    snespad_t* lead = service_lead(service);
+
+    while (!load_acquire(&service->stop)) {
+        uint32_t wait = service->mode == SNESPAD_SERVICE_TIMER ? snespad_service_step(service)
+                                                                : snespad_service_tick(service);
+
+        if (wait) {
+            delay_us(lead, wait);
+        }
+    }
+
+    store_release(&service->running, false);
+}
+
+#if defined(SERVICE_THREAD)
+
+static void* service_thread(void* arg)
+{
+    service_loop((snespad_service_t*)arg);
+    return NULL;
+}
+
+#elif defined(SERVICE_PICO)
+
+static snespad_service_t* core1_service;
+
+static void service_core1(void)
+{
+    service_loop(core1_service);
+}
+
+// One bus phase per alarm, re-armed at the next phase's deadline
+static int64_t service_alarm(alarm_id_t id, void* user_data)
+{
+    uint32_t wait = snespad_service_step((snespad_service_t*)user_data);
+
+    (void)id;
+    return wait ? wait : 1;  // > 0: fire again that many microseconds from now
+}
+
+#endif
+
+// ============================================================================
+// Public API Implementation
+// ============================================================================
+
+void snespad_service_init(snespad_service_t* service, uint8_t mode, uint32_t period_us)
+{
+    service->count = 0;
+    service->group = NULL;
+    service->mode = mode;
+    service->period_us = period_us;
+    service->next_us = 0;
+    service->round_us = 0;
+    service->index = 0;
+    service->stepping = false;
+    service->running = false;
+    service->stop = false;
+
+    service->health.loops = 0;
+    service->health.overruns = 0;
+    service->health.last_poll_us = 0;
+    service->health.max_poll_us = 0;
+    service->health.max_late_us = 0;
+}
+
+bool snespad_service_add(snespad_service_t* service, snespad_t* pad)
+{
+    if (service->count >= SNESPAD_SERVICE_MAX_PADS) {
+        return false;
+    }
+
+    service->pads[service->count++] = pad;
+    return true;
+}
+
+void snespad_service_set_group(snespad_service_t* service, snespad_group_t* group)
+{
+    service->group = group;
+}
+
+void snespad_service_set_period(snespad_service_t* service, uint32_t period_us)
+{
+    store_relaxed(&service->period_us, period_us);
+}
+
+bool snespad_service_start(snespad_service_t* service)
+{
+    if (service->running || (!service->group && !service->count) ||
+        (service->group && !service->group->count)) {
+        return false;
+    }
+
+    // Timer mode steps pads one phase at a time; a group only has a
+    // blocking read
+    if (service->mode == SNESPAD_SERVICE_TIMER && service->group) {
+        return false;
+    }
+
+    service->next_us = bus_now_us(service_lead(service));
+    service->stepping = false;
+    service->stop = false;
+    store_release(&service->running, true);
+
+#if defined(SERVICE_THREAD)
+    if (pthread_create(&service->thread, NULL, service_thread, service) != 0) {
+        service->running = false;
+        return false;
+    }
+    return true;
+#elif defined(SERVICE_PICO)
+    if (service->mode == SNESPAD_SERVICE_TIMER) {
+        service->alarm = add_alarm_in_us(1, service_alarm, service, true);
+        if (service->alarm < 0) {
+            service->running = false;
+            return false;
+        }
+        return true;
+    }
+
+    if (core1_service) {
+        service->running = false;
+        return false;  // core1 already runs a service
+    }
+    core1_service = service;
+    multicore_launch_core1(service_core1);
+    return true;
+#else
+    service->running = false;
+    return false;
+#endif
+}
+
+void snespad_service_stop(snespad_service_t* service)
+{
+    if (!service->running) {
+        return;
+    }
+
+#if defined(SERVICE_THREAD)
+    store_release(&service->stop, true);
+    pthread_join(service->thread, NULL);
+#elif defined(SERVICE_PICO)
+    if (service->mode == SNESPAD_SERVICE_TIMER) {
+        // A transfer cut short is finished by the next snespad_poll()
+        cancel_alarm(service->alarm);
+        service->running = false;
+        return;
+    }
+
+    store_release(&service->stop, true);
+    while (load_acquire(&service->running)) {
+        tight_loop_contents();
+    }
+    multicore_reset_core1();
+    core1_service = NULL;
+#endif
+}
+
+void snespad_service_health(const snespad_service_t* service, snespad_service_health_t* health)
+{
+    health->loops = load_relaxed(&service->health.loops);
+    health->overruns = load_relaxed(&service->health.overruns);
+    health->last_poll_us = load_relaxed(&service->health.last_poll_us);
+    health->max_poll_us = load_relaxed(&service->health.max_poll_us);
+    health->max_late_us = load_relaxed(&service->health.max_late_us);
+}
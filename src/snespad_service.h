@@ -0,0 +1,121 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Background polling service. Polls one or more pads (or a group) at a
+  fixed rate from RP2040 core1 or a hardware alarm, so the main core
+  never waits on the bus. The core1 loop runs whole polls; the alarm
+  advances the pads with snespad_poll_step() and re-arms at each phase
+  deadline, so every interrupt performs one latch or clock edge and
+  returns. Results reach the main core through the pads' snapshot slots
+  and event queues. On host builds (SNESPAD_HOST) the same loops run in a
+  pthread.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_SERVICE_H
+#define SNESPAD_SERVICE_H
+
+#include "snespad_c.h"
+#include "snespad_group.h"
+
+#if defined(SNESPAD_HOST)
+#include <pthread.h>
+#elif !defined(ARDUINO) || defined(ARDUINO_ARCH_RP2040)
+#include "pico/time.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SNESPAD_SERVICE_MAX_PADS  4
+
+// Where the polling loop runs
+#define SNESPAD_SERVICE_CORE1     0  // dedicated core1 loop (host: thread)
+#define SNESPAD_SERVICE_TIMER     1  // alarm stepping pads, not groups (host: thread)
+
+// Loop health (written by the service, read from anywhere)
+typedef struct {
+    uint32_t loops;             // Poll rounds completed
+    uint32_t overruns;          // Rounds that started a period or more late (never with period 0)
+    uint32_t last_poll_us;      // Bus time of the last round
+    uint32_t max_poll_us;       // Longest round
+    uint32_t max_late_us;       // Largest start delay past the scheduled time
+} snespad_service_health_t;
+
+typedef struct {
+    snespad_t* pads[SNESPAD_SERVICE_MAX_PADS];
+    uint8_t count;
+    snespad_group_t* group;     // Polled instead of pads when set
+
+    uint8_t mode;               // SNESPAD_SERVICE_*
+    uint32_t period_us;         // Poll period
+    uint32_t next_us;           // Bus time of the next round
+    uint32_t round_us;          // Bus time the current round started
+    uint8_t index;              // Pad being stepped (timer mode)
+    bool stepping;              // A timer mode round is in progress
+
+    bool running;               // Loop is active
+    bool stop;                  // Stop requested
+
+    snespad_service_health_t health;
+
+#if defined(SNESPAD_HOST)
+    pthread_t thread;
+#elif !defined(ARDUINO) || defined(ARDUINO_ARCH_RP2040)
+    alarm_id_t alarm;
+#endif
+} snespad_service_t;
+
+// Initialize a service polling every period_us (no pads yet)
+void snespad_service_init(snespad_service_t* service, uint8_t mode, uint32_t period_us);
+
+// Add a pad (after snespad_begin/snespad_start). Returns false if full.
+bool snespad_service_add(snespad_service_t* service, snespad_t* pad);
+
+// Poll a group instead of individual pads
+void snespad_service_set_group(snespad_service_t* service, snespad_group_t* group);
+
+// Change the poll period (takes effect on the next round)
+void snespad_service_set_period(snespad_service_t* service, uint32_t period_us);
+
+// Start polling in the background
+// Returns: false if already running, no pads were added, timer mode was
+// given a group, or the mode is unavailable on this platform (AVR has
+// neither core1 nor alarms here)
+bool snespad_service_start(snespad_service_t* service);
+
+// Stop polling and wait for the current round to finish
+void snespad_service_stop(snespad_service_t* service);
+
+// Copy the loop health counters
+void snespad_service_health(const snespad_service_t* service, snespad_service_health_t* health);
+
+// Scheduling step of the core1 loop: runs a whole round if one is due.
+// Returns: microseconds until the next round is due
+uint32_t snespad_service_tick(snespad_service_t* service);
+
+// Scheduling step of timer mode: starts a round if one is due and
+// advances it by at most one bus phase per pad (snespad_poll_step).
+// Returns: microseconds until the next phase or round can make progress
+uint32_t snespad_service_step(snespad_service_t* service);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_SERVICE_H
@@ -0,0 +1,754 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Host-side simulated bus (Linux).
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if defined(SNESPAD_HOST)
+
+#include "snespad_sim.h"
+#include "snespad_c.h"
+
+#include <string.h>
+
+#define LINE_DATA0  0
+#define LINE_DATA1  1
+#define LINE_IOBIT  2
+#define NO_OWNER    0xFF
+
+#define OUT_IDLE    0x03  // both data lines released (pulled high)
+
+// Mouse speed index (slow -> medium -> fast) to the code read back in bits 10-11
+static const uint8_t mouse_speed_code[3] = {
+    SNES_MOUSE_SLOW, SNES_MOUSE_MEDIUM, SNES_MOUSE_FAST
+};
+
+// ============================================================================
+// Device Models
+// ============================================================================
+
+static uint8_t sim_reverse7(uint8_t v)
+{
+    uint8_t r = 0;
+    for (uint8_t i = 0; i < 7; i++) {
+        r = (r << 1) | (v & 1);
+        v >>= 1;
+    }
+    return r;
+}
+
+static uint8_t sim_clamp_mag(int16_t v)
+{
+    if (v < 0) v = -v;
+    return v > 127 ? 127 : (uint8_t)v;
+}
+
+// Output levels for the current device state
+static uint8_t sim_port_levels(const snespad_sim_port_t* p)
+{
+    switch (p->kind) {
+        case SNESPAD_SIM_PAD:
+        case SNESPAD_SIM_NES:
+        case SNESPAD_SIM_MOUSE:
+        case SNESPAD_SIM_HYPERKIN:
+            if (p->bit >= 32) {
+                return OUT_IDLE & ~1;  // serial input tied to ground
+            }
+            return (OUT_IDLE & ~1) | ((p->shift >> p->bit) & 1);
+
+        case SNESPAD_SIM_KEYBOARD:
+            if (p->kb_active && p->kb_index < p->kb_len) {
+                return p->kb_dibits[p->kb_index];
+            }
+            return OUT_IDLE;
+
+        default:
+            return OUT_IDLE;  // pull_up
+    }
+}
+
+static void sim_update_out(snespad_sim_t* sim, snespad_sim_port_t* p)
+{
+    uint8_t levels = sim_port_levels(p);
+    uint8_t changed = levels ^ p->out;
+
+    if (!changed) {
+        return;
+    }
+    p->prev_out = p->out;
+    p->out = levels;
+    p->out_changed_us = sim->now_us;
+
+    // Device-driven edges for handlers watching the data lines (sniffer)
+    if ((changed & 1) && sim->edge_fn[p->data0_pin]) {
+        sim->edge_fn[p->data0_pin](sim->edge_arg[p->data0_pin], p->data0_pin, levels & 1);
+    }
+    if ((changed & 2) && sim->edge_fn[p->data1_pin]) {
+        sim->edge_fn[p->data1_pin](sim->edge_arg[p->data1_pin], p->data1_pin, (levels >> 1) & 1);
+    }
+}
+
+// Parallel load at the end of a latch pulse
+static void sim_port_load(snespad_sim_port_t* p)
+{
+    uint32_t packet;
+
+    switch (p->kind) {
+        case SNESPAD_SIM_PAD:
+            packet = p->buttons & 0x0FFF;  // id 0
+            break;
+
+        case SNESPAD_SIM_NES:
+            packet = (p->buttons & 0x00FF) | 0xFFFFFF00;  // reads low after 8 bits
+            break;
+
+        case SNESPAD_SIM_MOUSE:
+        case SNESPAD_SIM_HYPERKIN:
+            packet = p->buttons & (SNES_A | SNES_X);
+            packet |= (uint32_t)mouse_speed_code[p->mouse_speed] << 10;
+            packet |= (uint32_t)SNES_MOUSE_ID << 12;
+            packet |= (p->mouse_dy < 0) ? SNES_MOUSE_Y_SIGN : 0;
+            packet |= (uint32_t)sim_reverse7(sim_clamp_mag(p->mouse_dy)) << 17;
+            packet |= (p->mouse_dx < 0) ? SNES_MOUSE_X_SIGN : 0;
+            packet |= (uint32_t)sim_reverse7(sim_clamp_mag(p->mouse_dx)) << 25;
+            p->mouse_dx = 0;  // counters clear on every latch
+            p->mouse_dy = 0;
+            break;
+
+        default:
+            return;
+    }
+
+    p->shift = ~packet;
+    if (p->kind == SNESPAD_SIM_PAD) {
+        p->shift &= 0xFFFF;  // bits after 16 read low
+    }
+    p->bit = 0;
+}
+
+static uint8_t sim_keys_pending(const snespad_sim_port_t* p)
+{
+    return (uint8_t)(p->keys_head - p->keys_tail);
+}
+
+static void sim_kb_add_byte(snespad_sim_port_t* p, uint8_t value, uint8_t dibits)
+{
+    for (uint8_t i = 0; i < dibits; i++) {
+        p->kb_dibits[p->kb_len++] = (value >> (i * 2)) & 0x03;
+    }
+}
+
+// IOBit pulled low: build the id, count and scancode dibit stream
+static void sim_kb_begin(snespad_sim_port_t* p)
+{
+    uint8_t count = sim_keys_pending(p);
+
+    if (count > 15) count = 15;
+
+    p->kb_len = 0;
+    sim_kb_add_byte(p, SNES_KEYBOARD_ID, 4);
+    sim_kb_add_byte(p, count, 2);
+    for (uint8_t n = 0; n < count; n++) {
+        sim_kb_add_byte(p, p->keys[(uint8_t)(p->keys_tail + n) % SNESPAD_SIM_KEY_QUEUE], 4);
+    }
+
+    p->kb_count = count;
+    p->kb_index = 0;
+    p->kb_active = true;
+
+    if (p->kb_desync) {
+        p->kb_index = 1;  // first dibit lost
+        p->kb_desync = false;
+    }
+}
+
+// Transaction over: drop the scancodes that were fully clocked out
+static void sim_kb_end(snespad_sim_port_t* p)
+{
+    uint8_t sent = 0;
+
+    if (!p->kb_active) return;
+
+    if (p->kb_index > 6) {
+        sent = (p->kb_index - 6) / 4;
+    }
+    if (sent > p->kb_count) {
+        sent = p->kb_count;
+    }
+
+    p->keys_tail += sent;
+    p->kb_active = false;
+}
+
+static void sim_rumble_shift(snespad_sim_port_t* p, uint8_t iobit)
+{
+    p->rumble_shift = (p->rumble_shift << 1) | (iobit & 1);
+
+    if ((p->rumble_shift >> 8) == 0x72) {
+        p->rumble_left = p->rumble_shift & 0x0F;
+        p->rumble_right = (p->rumble_shift >> 4) & 0x0F;
+        p->rumble_frames++;
+        p->rumble_shift = 0;
+    }
+}
+
+// ============================================================================
+// Line Events
+// ============================================================================
+
+static void sim_latch_edge(snespad_sim_t* sim, uint8_t value)
+{
+    if (value) {
+        sim->latch_rise_us = sim->now_us;
+        sim->stats.latches++;
+
+        for (uint8_t i = 0; i < sim->port_count; i++) {
+            sim_kb_end(&sim->port[i]);
+            sim_update_out(sim, &sim->port[i]);
+        }
+        return;
+    }
+
+    for (uint8_t i = 0; i < sim->port_count; i++) {
+        snespad_sim_port_t* p = &sim->port[i];
+
+        if (p->kind == SNESPAD_SIM_NONE || p->kind == SNESPAD_SIM_KEYBOARD) continue;
+
+        if (sim->now_us - sim->latch_rise_us < p->timing.latch_us) {
+            sim->stats.short_latch++;  // load missed, old contents keep shifting
+            continue;
+        }
+
+        sim_port_load(p);
+        sim_update_out(sim, p);
+    }
+}
+
+static void sim_clock_edge(snespad_sim_t* sim, uint8_t value)
+{
+    bool latched = sim->level[sim->latch_pin] != 0;
+
+    if (!value) {
+        for (uint8_t i = 0; i < sim->port_count; i++) {
+            snespad_sim_port_t* p = &sim->port[i];
+
+            if (p->kind == SNESPAD_SIM_NONE) continue;
+
+            if (sim->now_us - sim->clock_rise_us < p->timing.clock_high_us) {
+                sim->stats.short_clock_high++;
+                p->edge_missed = true;
+            }
+        }
+        sim->clock_fall_us = sim->now_us;
+        return;
+    }
+
+    sim->clock_rise_us = sim->now_us;
+    sim->stats.clocks++;
+
+    for (uint8_t i = 0; i < sim->port_count; i++) {
+        snespad_sim_port_t* p = &sim->port[i];
+        bool missed = p->edge_missed;
+
+        p->edge_missed = false;
+        if (p->kind == SNESPAD_SIM_NONE) continue;
+
+        if (sim->now_us - sim->clock_fall_us < p->timing.clock_low_us) {
+            sim->stats.short_clock_low++;
+            missed = true;
+        }
+
+        if (p->rumble) {
+            sim_rumble_shift(p, sim->level[p->iobit_pin]);
+        }
+
+        if (missed) continue;
+
+        if (latched) {
+            // Clock pulse during latch cycles the mouse speed
+            if (p->kind == SNESPAD_SIM_MOUSE) {
+                p->mouse_speed = (p->mouse_speed + 1) % 3;
+            }
+            continue;
+        }
+
+        if (p->kind == SNESPAD_SIM_KEYBOARD) {
+            if (p->kb_active) {
+                if (p->kb_index == 4) {
+                    // IOBit held low through the count phase lights caps lock
+                    p->caps_led = !sim->level[p->iobit_pin];
+                }
+                p->kb_index++;
+                if (p->kb_index >= p->kb_len) {
+                    sim_kb_end(p);
+                }
+            }
+        } else if (p->bit < 32) {
+            p->bit++;  // shift on rising edge
+        }
+
+        sim_update_out(sim, p);
+    }
+}
+
+static void sim_iobit_edge(snespad_sim_t* sim, snespad_sim_port_t* p, uint8_t value)
+{
+    if (p->kind != SNESPAD_SIM_KEYBOARD) return;
+
+    if (!value && !sim->level[sim->latch_pin]) {
+        sim_kb_end(p);
+        sim_kb_begin(p);
+        sim_update_out(sim, p);
+    }
+}
+
+// ============================================================================
+// Script
+// ============================================================================
+
+static void sim_apply_event(snespad_sim_t* sim, const snespad_sim_event_t* ev)
+{
+    snespad_sim_timing_t timing;
+
+    if (ev->port >= sim->port_count) return;
+
+    switch (ev->action) {
+        case SNESPAD_SIM_EV_ATTACH:
+            snespad_sim_attach(sim, ev->port, (uint8_t)ev->arg);
+            break;
+        case SNESPAD_SIM_EV_DETACH:
+            snespad_sim_detach(sim, ev->port);
+            break;
+        case SNESPAD_SIM_EV_BUTTONS:
+            snespad_sim_set_buttons(sim, ev->port, (uint16_t)ev->arg);
+            break;
+        case SNESPAD_SIM_EV_MOUSE_MOVE:
+            snespad_sim_mouse_move(sim, ev->port, (int8_t)(ev->arg & 0xFF),
+                                   (int8_t)((ev->arg >> 8) & 0xFF));
+            break;
+        case SNESPAD_SIM_EV_KEY:
+            snespad_sim_key(sim, ev->port, (uint8_t)ev->arg);
+            break;
+        case SNESPAD_SIM_EV_BIT_ERRORS:
+            snespad_sim_inject_bit_errors(sim, ev->port, (uint16_t)ev->arg);
+            break;
+        case SNESPAD_SIM_EV_TIMING:
+            timing.latch_us = ev->arg & 0xFF;
+            timing.clock_low_us = (ev->arg >> 8) & 0xFF;
+            timing.clock_high_us = (ev->arg >> 16) & 0xFF;
+            timing.valid_us = (ev->arg >> 24) & 0xFF;
+            snespad_sim_set_timing(sim, ev->port, &timing);
+            break;
+        case SNESPAD_SIM_EV_KB_DESYNC:
+            sim->port[ev->port].kb_desync = true;
+            break;
+        case SNESPAD_SIM_EV_RUMBLE:
+            snespad_sim_set_rumble(sim, ev->port, ev->arg != 0);
+            break;
+        default:
+            break;
+    }
+}
+
+static void sim_run_script(snespad_sim_t* sim)
+{
+    while (sim->script_pos < sim->script_len &&
+           sim->script[sim->script_pos].at_us <= sim->now_us) {
+        sim_apply_event(sim, &sim->script[sim->script_pos++]);
+    }
+}
+
+// ============================================================================
+// Bus Callbacks
+// ============================================================================
+
+static uint32_t sim_random(snespad_sim_t* sim)
+{
+    uint32_t x = sim->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim->rng = x;
+    return x;
+}
+
+// Sample a data line the way the host would see it
+static uint8_t sim_sample(snespad_sim_t* sim, snespad_sim_port_t* p, uint8_t line)
+{
+    uint8_t levels = p->out;
+    uint8_t level;
+
+    if (p->kind != SNESPAD_SIM_NONE &&
+        sim->now_us - p->out_changed_us < p->timing.valid_us) {
+        sim->stats.late_samples++;
+        levels = p->prev_out;  // output still settling
+    }
+
+    level = (levels >> line) & 1;
+
+    if (p->flip_samples) {
+        p->flip_samples--;
+        sim->stats.bit_errors++;
+        level ^= 1;
+    } else if (sim->error_ppm && (sim_random(sim) % 1000000) < sim->error_ppm) {
+        sim->stats.bit_errors++;
+        level ^= 1;
+    }
+
+    return level;
+}
+
+static uint8_t sim_pin_level(snespad_sim_t* sim, uint8_t pin)
+{
+    uint8_t owner = sim->owner[pin];
+
+    if (owner != NO_OWNER && (owner & 0x03) != LINE_IOBIT) {
+        return sim_sample(sim, &sim->port[owner >> 2], owner & 0x03);
+    }
+    return sim->level[pin];
+}
+
+static void sim_pin_mode(void* ctx, uint8_t pin, uint8_t mode)
+{
+    snespad_sim_t* sim = (snespad_sim_t*)ctx;
+
+    if (pin < SNESPAD_SIM_MAX_PINS) {
+        sim->mode[pin] = mode;
+    }
+}
+
+static void sim_write(void* ctx, uint8_t pin, uint8_t value)
+{
+    snespad_sim_t* sim = (snespad_sim_t*)ctx;
+    uint8_t last;
+
+    if (pin >= SNESPAD_SIM_MAX_PINS) return;
+
+    sim_run_script(sim);
+
+    value = value ? 1 : 0;
+    last = sim->level[pin];
+    sim->level[pin] = value;
+    sim->stats.writes++;
+
+    if (value == last) return;
+
+    if (sim->edge_fn[pin]) {
+        sim->edge_fn[pin](sim->edge_arg[pin], pin, value);
+    }
+
+    if (pin == sim->latch_pin) {
+        sim_latch_edge(sim, value);
+    } else if (pin == sim->clock_pin) {
+        sim_clock_edge(sim, value);
+    } else if (sim->owner[pin] != NO_OWNER && (sim->owner[pin] & 0x03) == LINE_IOBIT) {
+        sim_iobit_edge(sim, &sim->port[sim->owner[pin] >> 2], value);
+    }
+}
+
+static uint8_t sim_read(void* ctx, uint8_t pin)
+{
+    snespad_sim_t* sim = (snespad_sim_t*)ctx;
+
+    if (pin >= SNESPAD_SIM_MAX_PINS) return 0;
+
+    sim_run_script(sim);
+    sim->stats.reads++;
+    return sim_pin_level(sim, pin);
+}
+
+static uint32_t sim_read_mask(void* ctx, uint32_t mask)
+{
+    snespad_sim_t* sim = (snespad_sim_t*)ctx;
+    uint32_t levels = 0;
+
+    sim_run_script(sim);
+    sim->stats.mask_reads++;
+    for (uint8_t pin = 0; pin < 32; pin++) {
+        if ((mask >> pin) & 1) {
+            levels |= (uint32_t)sim_pin_level(sim, pin) << pin;
+        }
+    }
+
+    return levels;
+}
+
+static void sim_delay_us(void* ctx, uint32_t us)
+{
+    snespad_sim_t* sim = (snespad_sim_t*)ctx;
+
+    sim->now_us += us;
+    sim->stats.bus_us += us;
+    sim_run_script(sim);
+}
+
+static uint32_t sim_now_us(void* ctx)
+{
+    snespad_sim_t* sim = (snespad_sim_t*)ctx;
+
+    return (uint32_t)sim->now_us;
+}
+
+static bool sim_attach_edge(void* ctx, uint8_t pin, snespad_edge_fn handler, void* arg)
+{
+    snespad_sim_t* sim = (snespad_sim_t*)ctx;
+
+    if (pin >= SNESPAD_SIM_MAX_PINS) return false;
+
+    sim->edge_arg[pin] = arg;
+    sim->edge_fn[pin] = handler;
+    return true;
+}
+
+// ============================================================================
+// Public API Implementation
+// ============================================================================
+
+void snespad_sim_init(snespad_sim_t* sim, uint8_t clock, uint8_t latch,
+                      uint8_t data0, uint8_t data1, uint8_t iobit)
+{
+    memset(sim, 0, sizeof(*sim));
+    memset(sim->owner, NO_OWNER, sizeof(sim->owner));
+
+    sim->bus.pin_mode = sim_pin_mode;
+    sim->bus.write = sim_write;
+    sim->bus.read = sim_read;
+    sim->bus.read_mask = sim_read_mask;
+    sim->bus.delay_us = sim_delay_us;
+    sim->bus.now_us = sim_now_us;
+    sim->bus.attach_edge = sim_attach_edge;
+    sim->bus.ctx = sim;
+
+    sim->clock_pin = clock;
+    sim->latch_pin = latch;
+    sim->level[clock] = 1;  // idle high
+    sim->rng = 0x2545F491;
+
+    snespad_sim_add_port(sim, data0, data1, iobit);
+    snespad_sim_attach(sim, 0, SNESPAD_SIM_PAD);
+}
+
+int snespad_sim_add_port(snespad_sim_t* sim, uint8_t data0, uint8_t data1, uint8_t iobit)
+{
+    uint8_t index = sim->port_count;
+    snespad_sim_port_t* p;
+
+    if (index >= SNESPAD_SIM_MAX_PORTS ||
+        data0 >= SNESPAD_SIM_MAX_PINS || data1 >= SNESPAD_SIM_MAX_PINS ||
+        iobit >= SNESPAD_SIM_MAX_PINS) {
+        return -1;
+    }
+
+    p = &sim->port[index];
+    memset(p, 0, sizeof(*p));
+    p->data0_pin = data0;
+    p->data1_pin = data1;
+    p->iobit_pin = iobit;
+    p->kind = SNESPAD_SIM_NONE;
+    p->out = OUT_IDLE;
+    p->prev_out = OUT_IDLE;
+    p->bit = 32;
+
+    sim->owner[data0] = (index << 2) | LINE_DATA0;
+    sim->owner[data1] = (index << 2) | LINE_DATA1;
+    sim->owner[iobit] = (index << 2) | LINE_IOBIT;
+    sim->level[iobit] = 1;
+
+    sim->port_count++;
+    return index;
+}
+
+const snespad_bus_t* snespad_sim_bus(snespad_sim_t* sim)
+{
+    return &sim->bus;
+}
+
+void snespad_sim_default_timing(uint8_t kind, snespad_sim_timing_t* timing)
+{
+    // Model defaults: discrete shift registers settle well within 1us,
+    // the microcontroller based mouse and keyboard need a few us per edge.
+    switch (kind) {
+        case SNESPAD_SIM_MOUSE:
+        case SNESPAD_SIM_HYPERKIN:
+            timing->latch_us = 2;
+            timing->clock_low_us = 3;
+            timing->clock_high_us = 3;
+            timing->valid_us = 2;
+            break;
+        case SNESPAD_SIM_KEYBOARD:
+            timing->latch_us = 2;
+            timing->clock_low_us = 4;
+            timing->clock_high_us = 4;
+            timing->valid_us = 3;
+            break;
+        default:
+            timing->latch_us = 1;
+            timing->clock_low_us = 1;
+            timing->clock_high_us = 1;
+            timing->valid_us = 0;
+            break;
+    }
+}
+
+void snespad_sim_attach(snespad_sim_t* sim, uint8_t port, uint8_t kind)
+{
+    snespad_sim_port_t* p;
+
+    if (port >= sim->port_count) return;
+
+    p = &sim->port[port];
+    p->kind = kind;
+    p->buttons = 0;
+    p->mouse_dx = 0;
+    p->mouse_dy = 0;
+    p->mouse_speed = 0;
+    p->keys_head = 0;
+    p->keys_tail = 0;
+    p->caps_led = false;
+    p->kb_active = false;
+    p->kb_desync = false;
+    p->shift = 0;
+    p->bit = 32;
+    p->edge_missed = false;
+    snespad_sim_default_timing(kind, &p->timing);
+
+    sim_update_out(sim, p);
+}
+
+void snespad_sim_detach(snespad_sim_t* sim, uint8_t port)
+{
+    snespad_sim_attach(sim, port, SNESPAD_SIM_NONE);
+}
+
+void snespad_sim_set_buttons(snespad_sim_t* sim, uint8_t port, uint16_t buttons)
+{
+    if (port < sim->port_count) {
+        sim->port[port].buttons = buttons;
+    }
+}
+
+void snespad_sim_mouse_move(snespad_sim_t* sim, uint8_t port, int dx, int dy)
+{
+    snespad_sim_port_t* p;
+    int x, y;
+
+    if (port >= sim->port_count) return;
+
+    p = &sim->port[port];
+    x = p->mouse_dx + dx;
+    y = p->mouse_dy + dy;
+    p->mouse_dx = x > 127 ? 127 : (x < -127 ? -127 : x);
+    p->mouse_dy = y > 127 ? 127 : (y < -127 ? -127 : y);
+}
+
+bool snespad_sim_key(snespad_sim_t* sim, uint8_t port, uint8_t scancode)
+{
+    snespad_sim_port_t* p;
+
+    if (port >= sim->port_count) return false;
+
+    p = &sim->port[port];
+    if (sim_keys_pending(p) >= SNESPAD_SIM_KEY_QUEUE) return false;
+
+    p->keys[p->keys_head % SNESPAD_SIM_KEY_QUEUE] = scancode;
+    p->keys_head++;
+    return true;
+}
+
+void snespad_sim_set_rumble(snespad_sim_t* sim, uint8_t port, bool enabled)
+{
+    if (port < sim->port_count) {
+        sim->port[port].rumble = enabled;
+        sim->port[port].rumble_shift = 0;
+    }
+}
+
+void snespad_sim_set_timing(snespad_sim_t* sim, uint8_t port, const snespad_sim_timing_t* timing)
+{
+    if (port < sim->port_count) {
+        sim->port[port].timing = *timing;
+    }
+}
+
+void snespad_sim_inject_bit_errors(snespad_sim_t* sim, uint8_t port, uint16_t count)
+{
+    if (port < sim->port_count) {
+        sim->port[port].flip_samples = count;
+    }
+}
+
+void snespad_sim_set_error_rate(snespad_sim_t* sim, uint32_t ppm, uint32_t seed)
+{
+    sim->error_ppm = ppm;
+    sim->rng = seed ? seed : 0x2545F491;
+}
+
+void snespad_sim_set_script(snespad_sim_t* sim, const snespad_sim_event_t* events, uint32_t count)
+{
+    sim->script = events;
+    sim->script_len = events ? count : 0;
+    sim->script_pos = 0;
+    sim_run_script(sim);
+}
+
+void snespad_sim_advance(snespad_sim_t* sim, uint32_t us)
+{
+    sim->now_us += us;
+    sim_run_script(sim);
+}
+
+uint64_t snespad_sim_now(const snespad_sim_t* sim)
+{
+    return sim->now_us;
+}
+
+void snespad_sim_reset_stats(snespad_sim_t* sim)
+{
+    memset(&sim->stats, 0, sizeof(sim->stats));
+}
+
+uint32_t snespad_sim_console_read(snespad_sim_t* sim, uint8_t data_pin,
+                                  uint8_t bits, uint8_t speed_pulses)
+{
+    uint32_t dat = 0;
+
+    if (data_pin >= SNESPAD_SIM_MAX_PINS) return 0;
+
+    sim_write(sim, sim->latch_pin, 1);
+    sim_delay_us(sim, 12);
+    for (uint8_t i = 0; i < speed_pulses; i++) {
+        sim_write(sim, sim->clock_pin, 0);
+        sim_delay_us(sim, 3);
+        sim_write(sim, sim->clock_pin, 1);
+        sim_delay_us(sim, 3);
+    }
+    sim_write(sim, sim->latch_pin, 0);
+    sim_delay_us(sim, 6);
+
+    for (uint8_t i = 0; i < bits && i < 32; i++) {
+        dat |= (uint32_t)(sim->level[data_pin] & 1) << i;
+        sim_write(sim, sim->clock_pin, 0);
+        sim_delay_us(sim, 6);
+        sim_write(sim, sim->clock_pin, 1);
+        sim_delay_us(sim, 6);
+    }
+
+    return dat;
+}
+
+#endif // SNESPAD_HOST
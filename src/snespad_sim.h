@@ -0,0 +1,259 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Host-side simulated bus (Linux). Compiled only when SNESPAD_HOST is
+  defined. Provides a snespad_bus_t backed by a virtual microsecond clock
+  and cycle-level models of the peripherals that answer on the latch,
+  clock, data0, data1 and IOBit lines, so the library can be benchmarked
+  and exercised without hardware.
+
+  Modelled devices:
+    - SNES controller (4021 style shift register, 16 bits)
+    - NES controller (8 bits, reads low afterwards)
+    - SNES mouse (32 bits, speed cycling on a clock pulse during latch)
+    - Hyperkin mouse (same, but never changes speed)
+    - XBAND keyboard (IOBit framed dibit transaction: id, count, scancodes)
+    - LRG rumble receiver (16-bit 0x72XX frames shifted in on IOBit)
+
+  The simulation can also play the console: snespad_sim_console_read()
+  drives latch and clock with SNES console timing and samples a data pin,
+  so device mode (snespad_device.h) can answer it through edge handlers
+  attached to the simulated bus.
+
+  Every device checks the host's latch width, clock low/high widths and
+  sample point against its own timing limits. Violations are counted and
+  corrupt the transfer the way marginal hardware would (missed shifts,
+  stale samples), so faster timing modes can be proven safe or unsafe.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_SIM_H
+#define SNESPAD_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "snespad_bus.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SNESPAD_SIM_MAX_PINS    64
+#define SNESPAD_SIM_MAX_PORTS   16
+#define SNESPAD_SIM_KEY_QUEUE   32   // pending keyboard scancodes per port
+
+// Simulated device kinds
+#define SNESPAD_SIM_NONE        0    // nothing plugged in (pull-ups)
+#define SNESPAD_SIM_PAD         1
+#define SNESPAD_SIM_NES         2
+#define SNESPAD_SIM_MOUSE       3
+#define SNESPAD_SIM_HYPERKIN    4    // mouse without speed cycling
+#define SNESPAD_SIM_KEYBOARD    5
+
+// Scripted event actions
+#define SNESPAD_SIM_EV_ATTACH      0  // arg = device kind
+#define SNESPAD_SIM_EV_DETACH      1
+#define SNESPAD_SIM_EV_BUTTONS     2  // arg = wire button mask
+#define SNESPAD_SIM_EV_MOUSE_MOVE  3  // arg = (uint8_t)dx | (uint8_t)dy << 8
+#define SNESPAD_SIM_EV_KEY         4  // arg = scancode to queue
+#define SNESPAD_SIM_EV_BIT_ERRORS  5  // arg = number of samples to flip
+#define SNESPAD_SIM_EV_TIMING      6  // arg = latch | low << 8 | high << 16 | valid << 24
+#define SNESPAD_SIM_EV_KB_DESYNC   7  // next keyboard transaction drops its first dibit
+#define SNESPAD_SIM_EV_RUMBLE      8  // arg = 1 to attach LRG receiver, 0 to remove
+
+// Minimum timing a device needs from the host (microseconds)
+typedef struct {
+    uint8_t latch_us;       // Latch high width
+    uint8_t clock_low_us;   // Clock low width
+    uint8_t clock_high_us;  // Clock high width
+    uint8_t valid_us;       // Output settle time after a shift before sampling
+} snespad_sim_timing_t;
+
+// Scripted event (scripts must be sorted by at_us)
+typedef struct {
+    uint64_t at_us;
+    uint8_t port;
+    uint8_t action;         // SNESPAD_SIM_EV_*
+    uint32_t arg;
+} snespad_sim_event_t;
+
+// Bus activity and fault counters
+typedef struct {
+    uint64_t bus_us;        // Virtual time spent in delay_us
+    uint32_t writes;        // Pin writes
+    uint32_t reads;         // Single pin reads
+    uint32_t mask_reads;    // Multi-pin reads
+    uint32_t latches;       // Latch rising edges
+    uint32_t clocks;        // Clock rising edges
+
+    uint32_t short_latch;       // Latch pulses below a device's minimum
+    uint32_t short_clock_low;   // Clock low phases below a device's minimum
+    uint32_t short_clock_high;  // Clock high phases below a device's minimum
+    uint32_t late_samples;      // Samples taken before the output settled
+    uint32_t bit_errors;        // Injected bit flips
+} snespad_sim_stats_t;
+
+// One simulated controller port
+typedef struct {
+    uint8_t kind;               // SNESPAD_SIM_*
+    uint8_t data0_pin;
+    uint8_t data1_pin;
+    uint8_t iobit_pin;
+    snespad_sim_timing_t timing;
+
+    // Inputs
+    uint16_t buttons;           // Pressed buttons, wire bit positions (SNES_*)
+    int16_t mouse_dx;           // Motion accumulated since last latch
+    int16_t mouse_dy;
+    uint8_t keys[SNESPAD_SIM_KEY_QUEUE];
+    uint8_t keys_head;
+    uint8_t keys_tail;
+
+    // Device state
+    uint32_t shift;             // Raw (line level) word loaded at latch
+    uint8_t bit;                // Current output bit index
+    uint8_t mouse_speed;        // Speed index: 0 = slow, 1 = medium, 2 = fast
+    bool caps_led;              // Keyboard caps lock LED
+
+    // Keyboard transaction
+    bool kb_active;
+    bool kb_desync;
+    uint8_t kb_index;           // Dibit being presented
+    uint8_t kb_len;             // Dibits in this transaction
+    uint8_t kb_count;           // Scancodes in this transaction
+    uint8_t kb_dibits[6 + 15 * 4];
+
+    // LRG rumble receiver
+    bool rumble;
+    uint16_t rumble_shift;
+    uint8_t rumble_left;        // Last motor intensities received (0-15)
+    uint8_t rumble_right;
+    uint32_t rumble_frames;
+
+    // Output timing
+    uint8_t out;                // Current output levels (bit0 = data0, bit1 = data1)
+    uint8_t prev_out;           // Levels before the last change
+    uint64_t out_changed_us;
+    uint16_t flip_samples;      // Pending injected bit errors
+    bool edge_missed;           // Current clock cycle was too short to register
+} snespad_sim_port_t;
+
+// Simulated bus state
+typedef struct {
+    snespad_bus_t bus;
+
+    // Virtual clock (advanced by delay_us and snespad_sim_advance)
+    uint64_t now_us;
+
+    // Pin state as seen by the simulated wires
+    uint8_t level[SNESPAD_SIM_MAX_PINS];
+    uint8_t mode[SNESPAD_SIM_MAX_PINS];
+    uint8_t owner[SNESPAD_SIM_MAX_PINS];   // port << 2 | line, 0xFF = none
+
+    // Shared lines
+    uint8_t latch_pin;
+    uint8_t clock_pin;
+    uint64_t latch_rise_us;
+    uint64_t clock_fall_us;
+    uint64_t clock_rise_us;
+
+    snespad_sim_port_t port[SNESPAD_SIM_MAX_PORTS];
+    uint8_t port_count;
+
+    // Edge handlers attached through the bus (device mode)
+    snespad_edge_fn edge_fn[SNESPAD_SIM_MAX_PINS];
+    void* edge_arg[SNESPAD_SIM_MAX_PINS];
+
+    // Scripted events
+    const snespad_sim_event_t* script;
+    uint32_t script_len;
+    uint32_t script_pos;
+
+    // Random bit errors
+    uint32_t error_ppm;
+    uint32_t rng;
+
+    snespad_sim_stats_t stats;
+} snespad_sim_t;
+
+// Initialize a simulated bus with one port (same pin order as snespad_init)
+// Port 0 starts with a SNES controller attached.
+void snespad_sim_init(snespad_sim_t* sim, uint8_t clock, uint8_t latch,
+                      uint8_t data0, uint8_t data1, uint8_t iobit);
+
+// Add a port sharing latch and clock. Returns the port index, or -1.
+int snespad_sim_add_port(snespad_sim_t* sim, uint8_t data0, uint8_t data1, uint8_t iobit);
+
+// Bus transport driving this simulation (pass to snespad_set_bus)
+const snespad_bus_t* snespad_sim_bus(snespad_sim_t* sim);
+
+// Plug a device into a port (resets its state and timing to the defaults)
+void snespad_sim_attach(snespad_sim_t* sim, uint8_t port, uint8_t kind);
+
+// Unplug whatever is in a port
+void snespad_sim_detach(snespad_sim_t* sim, uint8_t port);
+
+// Set held buttons using wire bit positions (SNES_*). For NES pads SNES_B
+// is A and SNES_Y is B; for mice SNES_X is left and SNES_A is right.
+void snespad_sim_set_buttons(snespad_sim_t* sim, uint8_t port, uint16_t buttons);
+
+// Move the mouse (counts accumulate until the next latch, saturating at 127)
+void snespad_sim_mouse_move(snespad_sim_t* sim, uint8_t port, int dx, int dy);
+
+// Queue a keyboard scancode. Returns false if the queue is full.
+bool snespad_sim_key(snespad_sim_t* sim, uint8_t port, uint8_t scancode);
+
+// Attach or remove an LRG rumble receiver on a port
+void snespad_sim_set_rumble(snespad_sim_t* sim, uint8_t port, bool enabled);
+
+// Override a device's minimum timing
+void snespad_sim_set_timing(snespad_sim_t* sim, uint8_t port, const snespad_sim_timing_t* timing);
+
+// Default timing used for a device kind
+void snespad_sim_default_timing(uint8_t kind, snespad_sim_timing_t* timing);
+
+// Flip the next count samples taken from a port
+void snespad_sim_inject_bit_errors(snespad_sim_t* sim, uint8_t port, uint16_t count);
+
+// Flip samples at random (parts per million, 0 = off)
+void snespad_sim_set_error_rate(snespad_sim_t* sim, uint32_t ppm, uint32_t seed);
+
+// Run a sorted list of events as virtual time passes (NULL to clear)
+void snespad_sim_set_script(snespad_sim_t* sim, const snespad_sim_event_t* events, uint32_t count);
+
+// Let virtual time pass without bus activity
+void snespad_sim_advance(snespad_sim_t* sim, uint32_t us);
+
+// Current virtual time in microseconds
+uint64_t snespad_sim_now(const snespad_sim_t* sim);
+
+// Clear bus activity and fault counters
+void snespad_sim_reset_stats(snespad_sim_t* sim);
+
+// Console side: latch, optional clock pulses during latch (mouse speed
+// cycling), then clock in bits from data_pin with SNES console timing
+// (12us latch, 6us clock phases, sampled before each rising edge)
+// Returns: raw line levels, bit i = i-th bit clocked in
+uint32_t snespad_sim_console_read(snespad_sim_t* sim, uint8_t data_pin,
+                                  uint8_t bits, uint8_t speed_pulses);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_SIM_H
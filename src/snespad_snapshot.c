@@ -0,0 +1,77 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Published state snapshots.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_snapshot.h"
+
+#include <string.h>
+
+void snespad_snapshot_init(snespad_snapshot_slot_t* slot)
+{
+    memset(&slot->data, 0, sizeof(slot->data));
+    slot->data.type = -1;  // SNESPAD_NONE
+    __atomic_store_n(&slot->seq, 0, __ATOMIC_RELEASE);
+}
+
+void snespad_snapshot_write(snespad_snapshot_slot_t* slot, const snespad_snapshot_t* snapshot)
+{
+    uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+
+    // Odd sequence marks the data as being written; the fence keeps the
+    // data stores after it
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(&slot->data, snapshot, sizeof(*snapshot));
+
+    __atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+bool snespad_snapshot_try_read(const snespad_snapshot_slot_t* slot, snespad_snapshot_t* snapshot, uint32_t* seq)
+{
+    uint32_t begin = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+
+    if (begin & 1) {
+        return false;
+    }
+
+    memcpy(snapshot, &slot->data, sizeof(*snapshot));
+
+    // The copy must complete before the sequence is checked again
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != begin) {
+        return false;
+    }
+
+    if (seq) {
+        *seq = begin;
+    }
+    return true;
+}
+
+uint32_t snespad_snapshot_read(const snespad_snapshot_slot_t* slot, snespad_snapshot_t* snapshot)
+{
+    uint32_t seq;
+
+    while (!snespad_snapshot_try_read(slot, snapshot, &seq)) {
+    }
+
+    return seq;
+}
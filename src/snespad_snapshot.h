@@ -0,0 +1,75 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Published state snapshots. When polling runs on the other RP2040 core,
+  in a timer ISR or in another thread, readers copy the pad state out of a
+  sequence-counted slot instead of reading snespad_t fields that may be
+  half updated. The writer never waits and readers never take locks or
+  disable interrupts; a reader that overlaps a write simply retries.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_SNAPSHOT_H
+#define SNESPAD_SNAPSHOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pad state as of one completed poll
+typedef struct {
+    uint32_t time_us;           // Bus clock time of the poll's latch
+    int8_t type;                // Device type (SNESPAD_*)
+    uint16_t buttons;           // Held buttons (SNES_* masks)
+    uint16_t pressed;           // Went down during that poll
+    uint16_t released;          // Went up during that poll
+    uint16_t mouse_x;
+    uint16_t mouse_y;
+    uint8_t scancodes[16];
+    uint8_t scancodes_len;
+} snespad_snapshot_t;
+
+// Sequence-counted slot (single writer, any number of readers)
+typedef struct snespad_snapshot_slot {
+    uint32_t seq;               // Odd while a write is in progress
+    snespad_snapshot_t data;
+} snespad_snapshot_slot_t;
+
+// Initialize an empty slot (type SNESPAD_NONE, sequence 0)
+void snespad_snapshot_init(snespad_snapshot_slot_t* slot);
+
+// Writer: publish a snapshot
+void snespad_snapshot_write(snespad_snapshot_slot_t* slot, const snespad_snapshot_t* snapshot);
+
+// Reader: copy the latest consistent snapshot, retrying while a write is
+// in progress. Do not call from an ISR that can interrupt the writer on
+// the same core (it would spin forever); use snespad_snapshot_try_read.
+// Returns: sequence number of the snapshot (changes on every publish)
+uint32_t snespad_snapshot_read(const snespad_snapshot_slot_t* slot, snespad_snapshot_t* snapshot);
+
+// Reader: single attempt
+// Returns: false if a write overlapped the copy (snapshot is unusable)
+bool snespad_snapshot_try_read(const snespad_snapshot_slot_t* slot, snespad_snapshot_t* snapshot, uint32_t* seq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_SNAPSHOT_H
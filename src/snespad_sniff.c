@@ -0,0 +1,230 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Sniffer mode: decode traffic between a console and its controller.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_sniff.h"
+#include "snespad_internal.h"
+
+#include <stddef.h>
+
+// The interrupt writes head, the task writes tail
+#define RING_MASK (SNESPAD_SNIFF_RING_SIZE - 1)
+
+#define LRG_HEADER  0x72    // rumble frame: 0x72, then right << 4 | left
+
+#define EDGE_GAP    0x80    // edges were lost right before this one
+
+// Pin of line i (bit i of SNESPAD_LINE_*)
+static uint8_t sniff_pin(const snespad_t* pad, uint8_t line)
+{
+    switch (line) {
+        case 0:  return pad->latch_pin;
+        case 1:  return pad->clock_pin;
+        case 2:  return pad->data0_pin;
+        case 3:  return pad->data1_pin;
+        default: return pad->iobit_pin;
+    }
+}
+
+// Any line edge: timestamp the new line levels, nothing else
+static void sniff_edge(void* arg, uint8_t pin, uint8_t level)
+{
+    snespad_sniffer_t* s = (snespad_sniffer_t*)arg;
+    const snespad_t* pad = s->pad;
+    const snespad_bus_t* bus = pad->bus;
+    uint16_t head = s->head;
+    uint8_t bit = pin == pad->latch_pin ? SNESPAD_LINE_LATCH :
+                  pin == pad->clock_pin ? SNESPAD_LINE_CLOCK :
+                  pin == pad->data0_pin ? SNESPAD_LINE_DATA0 :
+                  pin == pad->data1_pin ? SNESPAD_LINE_DATA1 : SNESPAD_LINE_IOBIT;
+    snespad_sniff_edge_t* e;
+
+    s->lines = level ? s->lines | bit : s->lines & ~bit;
+
+    if ((uint16_t)(head - load_acquire(&s->tail)) >= SNESPAD_SNIFF_RING_SIZE) {
+        s->overruns++;
+        s->gap = true;
+        return;
+    }
+
+    e = &s->ring[head & RING_MASK];
+    e->time_us = bus->now_us(bus->ctx);
+    e->lines = s->lines | (s->gap ? EDGE_GAP : 0);
+    s->gap = false;
+    store_release(&s->head, (uint16_t)(head + 1));
+}
+
+// LRG rumble frame on IOBit: update the motors and queue an event
+static void sniff_rumble(snespad_t* pad, const snespad_frame_t* f)
+{
+    uint8_t l = f->iobit & 0x0F;
+    uint8_t r = (f->iobit >> 4) & 0x0F;
+
+    if (f->bits < 16 || (f->iobit >> 8) != LRG_HEADER) {
+        return;
+    }
+    if (l == pad->rumble_left && r == pad->rumble_right) {
+        return;
+    }
+    pad->rumble_left = l;
+    pad->rumble_right = r;
+
+    if (pad->events) {
+        snespad_event_t event;
+
+        event.time_us = f->latch_us;
+        event.type = SNESPAD_EVENT_RUMBLE;
+        event.port = pad->event_port;
+        event.code = f->iobit & 0xFF;
+        event.dx = 0;
+        event.dy = 0;
+        snespad_event_push(pad->events, &event);
+    }
+}
+
+// Count and decode one observed transaction
+static void sniff_apply(snespad_sniffer_t* s, const snespad_frame_t* f)
+{
+    s->frames++;
+    if (f->resync) {
+        s->resyncs++;
+    }
+    s->last = *f;
+    snespad_sniff_decode(s->pad, f);
+}
+
+// ============================================================================
+// Public API Implementation
+// ============================================================================
+
+void snespad_sniffer_init(snespad_sniffer_t* sniffer, snespad_t* pad)
+{
+    sniffer->pad = pad;
+    sniffer->lines = 0;
+    sniffer->head = 0;
+    sniffer->gap = false;
+    sniffer->overruns = 0;
+
+    sniffer->tail = 0;
+    snespad_framer_init(&sniffer->framer);
+    sniffer->last_edge_us = 0;
+
+    sniffer->frames = 0;
+    sniffer->dropped = 0;
+    sniffer->resyncs = 0;
+}
+
+bool snespad_sniffer_begin(snespad_sniffer_t* sniffer)
+{
+    const snespad_t* pad = sniffer->pad;
+    const snespad_bus_t* bus = pad->bus;
+
+    if (!bus || !bus->attach_edge) {
+        return false;
+    }
+
+    sniffer->lines = 0;
+    for (uint8_t i = 0; i < 5; i++) {
+        bus->pin_mode(bus->ctx, sniff_pin(pad, i), SNESPAD_PIN_INPUT);
+    }
+
+    for (uint8_t i = 0; i < 5; i++) {
+        if (bus->read(bus->ctx, sniff_pin(pad, i))) {
+            sniffer->lines |= 1 << i;
+        }
+    }
+
+    for (uint8_t i = 0; i < 5; i++) {
+        if (!bus->attach_edge(bus->ctx, sniff_pin(pad, i), sniff_edge, sniffer)) {
+            while (i--) {
+                bus->attach_edge(bus->ctx, sniff_pin(pad, i), NULL, NULL);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+void snespad_sniffer_end(snespad_sniffer_t* sniffer)
+{
+    const snespad_t* pad = sniffer->pad;
+    const snespad_bus_t* bus = pad->bus;
+
+    for (uint8_t i = 0; i < 5; i++) {
+        bus->attach_edge(bus->ctx, sniff_pin(pad, i), NULL, NULL);
+    }
+}
+
+void snespad_sniff_decode(snespad_t* pad, const snespad_frame_t* frame)
+{
+    snespad_xfer_t* x = &pad->xfer;
+
+    snespad_clear_edges(pad);
+    snespad_xfer_begin(pad, pad->type != SNESPAD_NONE ? XFER_MODE_POLL : XFER_MODE_START);
+    x->latch_us = frame->latch_us;
+    x->dat = frame->packet;
+    x->disconnected = frame->disconnected;
+    x->kid = frame->keyboard ? frame->kid : 0;
+    pad->mouse_speed_pulses = frame->speed_pulses;
+    pad->scancodes_len = frame->keyboard ? frame->num : 0;  // the count, as a host read reports it
+    for (uint8_t i = 0; i < 16; i++) {
+        pad->scancodes[i] = frame->scancodes[i];
+    }
+
+    // A lost device is detected again from the next transaction
+    snespad_xfer_complete(pad);
+    snespad_poll_done(pad);
+
+    sniff_rumble(pad, frame);
+}
+
+uint8_t snespad_sniffer_task(snespad_sniffer_t* sniffer)
+{
+    snespad_frame_t frame;
+    uint16_t head = load_acquire(&sniffer->head);
+    uint16_t tail = sniffer->tail;
+    uint8_t decoded = 0;
+
+    while (tail != head) {
+        const snespad_sniff_edge_t* e = &sniffer->ring[tail & RING_MASK];
+
+        // The transaction the lost edges belonged to cannot be trusted
+        if (e->lines & EDGE_GAP) {
+            snespad_framer_reset(&sniffer->framer);
+            sniffer->dropped++;
+        }
+
+        sniffer->last_edge_us = e->time_us;
+        if (snespad_framer_edge(&sniffer->framer, e->time_us, e->lines & ~EDGE_GAP, &frame)) {
+            sniff_apply(sniffer, &frame);
+            decoded++;
+        }
+        store_release(&sniffer->tail, (uint16_t)++tail);
+    }
+
+    // A console reading only 16 bits leaves nothing after them to end on
+    if ((uint32_t)(bus_now_us(sniffer->pad) - sniffer->last_edge_us) >= SNESPAD_SNIFF_IDLE_US &&
+        snespad_framer_flush(&sniffer->framer, &frame)) {
+        sniff_apply(sniffer, &frame);
+        decoded++;
+    }
+
+    return decoded;
+}
@@ -0,0 +1,114 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Sniffer mode: all five port lines are inputs and the library watches a
+  console (or another host) talk to its controller. Edge interrupts on
+  every line only timestamp the new line levels into a capture ring;
+  snespad_sniffer_task() drains the ring outside the interrupt, splits it
+  into transactions (snespad_frame.h) and decodes each one through the
+  same path as snespad_poll(), so the pad gets the usual buttons, mouse,
+  keyboard scancodes, events, snapshots and record log. LRG rumble frames
+  seen on IOBit update rumble_left/rumble_right and queue
+  SNESPAD_EVENT_RUMBLE.
+
+  The interrupt must finish well inside a 6us clock phase and the bus
+  must interrupt on all five pins (RP2040 does, with the pico-sdk or the
+  arduino-pico core; AVR boards do neither, an Uno has two interrupt
+  pins), and the ring must be drained before it fills: a keyboard
+  transaction with 15 scancodes is about 350 edges.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_SNIFF_H
+#define SNESPAD_SNIFF_H
+
+#include "snespad_c.h"
+#include "snespad_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Capture ring capacity in edges (power of two); AVR boards cannot sniff
+// at full speed, so their default ring does not take a quarter of the RAM
+#ifndef SNESPAD_SNIFF_RING_SIZE
+#if defined(__AVR__)
+#define SNESPAD_SNIFF_RING_SIZE 32
+#else
+#define SNESPAD_SNIFF_RING_SIZE 512
+#endif
+#endif
+
+#if (SNESPAD_SNIFF_RING_SIZE & (SNESPAD_SNIFF_RING_SIZE - 1)) || SNESPAD_SNIFF_RING_SIZE < 2
+#error "SNESPAD_SNIFF_RING_SIZE must be a power of two"
+#endif
+
+// Bus quiet this long ends the transaction in progress
+#define SNESPAD_SNIFF_IDLE_US   1000
+
+// One captured edge
+typedef struct {
+    uint32_t time_us;
+    uint8_t lines;              // SNESPAD_LINE_* levels right after the edge
+} snespad_sniff_edge_t;
+
+typedef struct {
+    snespad_t* pad;             // Decoded state (pins and bus taken from it)
+
+    // Interrupt side
+    uint8_t lines;              // SNESPAD_LINE_* levels
+    snespad_sniff_edge_t ring[SNESPAD_SNIFF_RING_SIZE];
+    uint16_t head;              // Next slot to write
+    bool gap;                   // Edges were lost since the last one stored
+    volatile uint32_t overruns; // Edges lost to a full ring
+
+    // Task side
+    uint16_t tail;              // Next slot to read
+    snespad_framer_t framer;
+    uint32_t last_edge_us;
+
+    // Results
+    uint32_t frames;            // Transactions decoded
+    uint32_t dropped;           // Transactions cut short by lost edges
+    uint32_t resyncs;           // Keyboard transactions that needed re-aligning
+    snespad_frame_t last;       // Most recent transaction
+} snespad_sniffer_t;
+
+// Initialize a sniffer for a pad (after snespad_init / snespad_set_bus;
+// do not call snespad_begin, which drives the lines)
+void snespad_sniffer_init(snespad_sniffer_t* sniffer, snespad_t* pad);
+
+// Make every line an input and attach an edge handler to each
+// Returns: false if the bus cannot interrupt on all five pins
+bool snespad_sniffer_begin(snespad_sniffer_t* sniffer);
+
+// Detach the handlers
+void snespad_sniffer_end(snespad_sniffer_t* sniffer);
+
+// Call often from the main loop: decode the captured edges into the pad
+// Returns: the number of transactions decoded
+uint8_t snespad_sniffer_task(snespad_sniffer_t* sniffer);
+
+// Decode one observed transaction into a pad as if it had just polled it
+// (what the sniffer does with every frame; also for frames from captures)
+void snespad_sniff_decode(snespad_t* pad, const snespad_frame_t* frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_SNIFF_H
@@ -0,0 +1,242 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Bus trace ring and VCD export.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "snespad_c.h"
+
+#if SNESPAD_TRACE
+
+#include "snespad_trace.h"
+#include "snespad_internal.h"
+
+// The pad writes head, the drain writes tail
+#define TRACE_MASK (SNESPAD_TRACE_SIZE - 1)
+
+#define TRACE_IDLE  (SNESPAD_LINE_CLOCK | SNESPAD_LINE_DATA0 | SNESPAD_LINE_DATA1 | SNESPAD_LINE_IOBIT)
+#define TRACE_DATA  (SNESPAD_LINE_DATA0 | SNESPAD_LINE_DATA1)
+
+// VCD identifiers: latch, clock, data0, data1, iobit, sample marker
+static const char vcd_ids[6] = { '!', '"', '#', '$', '%', '&' };
+
+static const char vcd_header[] =
+    "$timescale 1ns $end\n"
+    "$scope module snespad $end\n"
+    "$var wire 1 ! latch $end\n"
+    "$var wire 1 \" clock $end\n"
+    "$var wire 1 # data0 $end\n"
+    "$var wire 1 $ data1 $end\n"
+    "$var wire 1 % iobit $end\n"
+    "$var wire 1 & sample $end\n"
+    "$upscope $end\n"
+    "$enddefinitions $end\n";
+
+// Text for one entry: up to two "#<time>\n" and seven "<v><id>\n"
+typedef struct {
+    uint8_t buf[80];
+    uint8_t len;
+} vcd_text_t;
+
+static void vcd_time(vcd_text_t* t, uint64_t time_us)
+{
+    char digits[20];
+    uint8_t n = 0;
+
+    do {
+        digits[n++] = '0' + time_us % 10;
+        time_us /= 10;
+    } while (time_us);
+
+    t->buf[t->len++] = '#';
+    while (n) {
+        t->buf[t->len++] = digits[--n];
+    }
+    t->buf[t->len++] = '\n';
+}
+
+static void vcd_value(vcd_text_t* t, uint8_t id, bool level)
+{
+    t->buf[t->len++] = level ? '1' : '0';
+    t->buf[t->len++] = vcd_ids[id];
+    t->buf[t->len++] = '\n';
+}
+
+// Write one entry's changes (and its sample marker)
+static void vcd_entry(snespad_trace_vcd_t* vcd, const snespad_trace_entry_t* e)
+{
+    uint8_t lines = e->lines & ~SNESPAD_TRACE_SAMPLE;
+    bool sample = (e->lines & SNESPAD_TRACE_SAMPLE) != 0;
+    uint64_t time_ns;
+    vcd_text_t t;
+
+    if (!vcd->started) {
+        vcd->started = true;
+        vcd->time_us = e->time_us;
+    } else {
+        vcd->time_us += (uint32_t)(e->time_us - vcd->last_us);
+    }
+    vcd->last_us = e->time_us;
+
+    t.len = 0;
+    if (vcd->sample) {
+        // The marker falls a nanosecond after it rose
+        vcd->written_ns++;
+        vcd_time(&t, vcd->written_ns);
+        vcd_value(&t, 5, false);
+        vcd->sample = false;
+    }
+
+    if (lines != vcd->lines || sample) {
+        // Entries within the same microsecond keep their order 1 ns apart
+        time_ns = vcd->time_us * 1000;
+        if (time_ns <= vcd->written_ns) {
+            time_ns = vcd->written_ns + 1;
+        }
+        vcd->written_ns = time_ns;
+        vcd_time(&t, time_ns);
+
+        for (uint8_t id = 0; id < 5; id++) {
+            if ((lines ^ vcd->lines) & (1 << id)) {
+                vcd_value(&t, id, (lines >> id) & 1);
+            }
+        }
+        vcd->lines = lines;
+
+        if (sample) {
+            vcd_value(&t, 5, true);
+            vcd->sample = true;
+        }
+    }
+
+    if (t.len) {
+        vcd->write(vcd->ctx, t.buf, t.len);
+    }
+}
+
+// Write the entries held since the last shift edge
+static void vcd_flush(snespad_trace_vcd_t* vcd)
+{
+    for (uint8_t k = 0; k < vcd->held_len; k++) {
+        vcd_entry(vcd, &vcd->held[k]);
+    }
+    vcd->held_len = 0;
+}
+
+// ============================================================================
+// Public API Implementation
+// ============================================================================
+
+void snespad_trace_init(snespad_trace_t* trace)
+{
+    trace->head = 0;
+    trace->tail = 0;
+    trace->dropped = 0;
+    trace->now_us = 0;
+    trace->lines = TRACE_IDLE;
+}
+
+uint16_t snespad_trace_drain(snespad_trace_t* trace, snespad_trace_entry_t* out, uint16_t max)
+{
+    uint16_t tail = trace->tail;
+    uint16_t count = (uint16_t)(load_acquire(&trace->head) - tail);
+
+    if (count > max) {
+        count = max;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        out[i] = trace->ring[(uint16_t)(tail + i) & TRACE_MASK];
+    }
+    store_release(&trace->tail, (uint16_t)(tail + count));
+    return count;
+}
+
+void snespad_trace_vcd_begin(snespad_trace_vcd_t* vcd, snespad_trace_write_fn write, void* ctx)
+{
+    vcd_text_t t;
+
+    vcd->write = write;
+    vcd->ctx = ctx;
+    vcd->started = false;
+    vcd->sample = false;
+    vcd->lines = TRACE_IDLE;
+    vcd->last_us = 0;
+    vcd->time_us = 0;
+    vcd->written_ns = 0;
+    vcd->prev = TRACE_IDLE;
+    vcd->held_len = 0;
+
+    write(ctx, (const uint8_t*)vcd_header, sizeof(vcd_header) - 1);
+
+    // Idle levels at time zero
+    t.len = 0;
+    vcd_time(&t, 0);
+    for (uint8_t id = 0; id < 5; id++) {
+        vcd_value(&t, id, (vcd->lines >> id) & 1);
+    }
+    vcd_value(&t, 5, false);
+    write(ctx, t.buf, t.len);
+}
+
+void snespad_trace_vcd_write(snespad_trace_vcd_t* vcd, const snespad_trace_entry_t* entries,
+                             uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++) {
+        snespad_trace_entry_t e = entries[i];
+        uint8_t lines = e.lines & ~SNESPAD_TRACE_SAMPLE;
+        bool shift = (!(vcd->prev & SNESPAD_LINE_CLOCK) && (lines & SNESPAD_LINE_CLOCK)) ||
+                     ((vcd->prev & SNESPAD_LINE_LATCH) && !(lines & SNESPAD_LINE_LATCH));
+
+        vcd->prev = lines;
+
+        if (shift) {
+            vcd_flush(vcd);
+            vcd->held[vcd->held_len++] = e;
+        } else if (e.lines & SNESPAD_TRACE_SAMPLE) {
+            // The device shifted the sampled level out at the held edge
+            for (uint8_t k = 0; k < vcd->held_len; k++) {
+                vcd->held[k].lines = (vcd->held[k].lines & ~TRACE_DATA) | (lines & TRACE_DATA);
+            }
+            vcd_flush(vcd);
+            vcd_entry(vcd, &e);
+        } else if (vcd->held_len && vcd->held_len < SNESPAD_TRACE_VCD_HELD) {
+            vcd->held[vcd->held_len++] = e;
+        } else {
+            vcd_flush(vcd);
+            vcd_entry(vcd, &e);
+        }
+    }
+}
+
+void snespad_trace_vcd_end(snespad_trace_vcd_t* vcd)
+{
+    vcd_text_t t;
+
+    vcd_flush(vcd);
+    if (!vcd->sample) {
+        return;
+    }
+    t.len = 0;
+    vcd->written_ns++;
+    vcd_time(&t, vcd->written_ns);
+    vcd_value(&t, 5, false);
+    vcd->sample = false;
+    vcd->write(vcd->ctx, t.buf, t.len);
+}
+
+#endif // SNESPAD_TRACE
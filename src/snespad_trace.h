@@ -0,0 +1,122 @@
+/*
+  SNESpad - Arduino/Pico library for interfacing with SNES controllers
+
+  github.com/RobertDaleSmith/SNESpad
+
+  Bus trace (SNESPAD_TRACE builds). A pad with a trace ring records every
+  edge its transfers drive (latch, clock, IOBit) and every data sample
+  they take, as a timestamp and the five line levels after it. Entries
+  are drained later, from the main loop or another core, and can be
+  written out as a value change dump for GTKWave or snespad_capture.h.
+
+  Recording is a few stores per edge and does not touch the bus: the
+  timestamp is the bus clock read once at each latch plus the hold times
+  the transfer requested since, so it shows the intended timing (a
+  snespad_poll_step() caller that comes back late stretches the real
+  bus, not the trace). With SNESPAD_TRACE 0 (default) the pad has no
+  trace pointer and the hooks compile to nothing.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU Lesser General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SNESPAD_TRACE_H
+#define SNESPAD_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "snespad_frame.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Ring capacity in entries (power of two); a keyboard transaction with
+// 15 scancodes is about 400 entries
+#ifndef SNESPAD_TRACE_SIZE
+#define SNESPAD_TRACE_SIZE 512
+#endif
+
+#if (SNESPAD_TRACE_SIZE & (SNESPAD_TRACE_SIZE - 1)) || SNESPAD_TRACE_SIZE < 2 || \
+    SNESPAD_TRACE_SIZE > 32768
+#error "SNESPAD_TRACE_SIZE must be a power of two from 2 to 32768"
+#endif
+
+// Entry flag: data0/data1 were sampled (not driven) at this time
+#define SNESPAD_TRACE_SAMPLE    0x80
+
+// One driven edge or data sample
+typedef struct {
+    uint32_t time_us;
+    uint8_t lines;              // SNESPAD_LINE_* levels after it, | SNESPAD_TRACE_SAMPLE
+} snespad_trace_entry_t;
+
+// Single-producer/single-consumer ring
+typedef struct snespad_trace {
+    snespad_trace_entry_t ring[SNESPAD_TRACE_SIZE];
+    uint16_t head;              // Next slot to write (pad)
+    uint16_t tail;              // Next slot to read (drain)
+    uint32_t dropped;           // Entries lost to a full ring (pad)
+    uint32_t now_us;            // Software clock: latch time plus the holds since
+    uint8_t lines;              // Levels as last driven or sampled
+} snespad_trace_t;
+
+// Entries the VCD writer holds back between a shift edge and the sample
+#define SNESPAD_TRACE_VCD_HELD  8
+
+// Stream sink for the VCD text
+typedef void (*snespad_trace_write_fn)(void* ctx, const uint8_t* data, uint32_t len);
+
+// VCD writer state
+typedef struct {
+    snespad_trace_write_fn write;
+    void* ctx;
+    bool started;               // First entry seen
+    bool sample;                // Sample marker is high
+    uint8_t lines;              // Levels written so far
+    uint32_t last_us;           // Time of the last entry (trace clock)
+    uint64_t time_us;           // last_us without wrapping
+    uint64_t written_ns;        // Last VCD time written
+    uint8_t prev;               // Levels of the last entry seen
+    snespad_trace_entry_t held[SNESPAD_TRACE_VCD_HELD];  // From the last shift edge on
+    uint8_t held_len;
+} snespad_trace_vcd_t;
+
+// Initialize an empty trace (lines idle: clock, data and IOBit high)
+void snespad_trace_init(snespad_trace_t* trace);
+
+// Take up to max of the oldest entries
+// Returns: the number taken
+uint16_t snespad_trace_drain(snespad_trace_t* trace, snespad_trace_entry_t* out, uint16_t max);
+
+// Write the VCD header and the idle levels at time zero (signals latch,
+// clock, data0, data1, iobit and a sample marker; 1 ns timescale, entries
+// within the same microsecond are placed 1 ns apart in order). A sampled
+// data level is dumped at the edge the device shifted it out on (the
+// clock rising edge or latch fall before the sample); the sample marker
+// stays at the sample itself.
+void snespad_trace_vcd_begin(snespad_trace_vcd_t* vcd, snespad_trace_write_fn write, void* ctx);
+
+// Write drained entries as value changes (call with each drained batch)
+void snespad_trace_vcd_write(snespad_trace_vcd_t* vcd, const snespad_trace_entry_t* entries,
+                             uint16_t count);
+
+// End the dump: writes entries still held back, the last sample marker falls
+void snespad_trace_vcd_end(snespad_trace_vcd_t* vcd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SNESPAD_TRACE_H